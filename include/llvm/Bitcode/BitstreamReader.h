@@ -37,11 +37,15 @@ namespace llvm {
 /// This class maintains the abbreviations read from a block info block.
 class BitstreamBlockInfo {
 public:
+  using AbbrevList = std::vector<std::shared_ptr<BitCodeAbbrev>>;
+
   /// This contains information emitted to BLOCKINFO_BLOCK blocks. These
   /// describe abbreviations that all blocks of the specified ID inherit.
   struct BlockInfo {
     unsigned BlockID;
-    std::vector<std::shared_ptr<BitCodeAbbrev>> Abbrevs;
+    /// Cursors share this list with every block of this ID they enter, so
+    /// entering a block doesn't copy the abbreviations.
+    std::shared_ptr<AbbrevList> Abbrevs = std::make_shared<AbbrevList>();
     std::string Name;
     std::vector<std::pair<unsigned, std::string>> RecordNames;
   };
@@ -314,14 +318,22 @@ class BitstreamCursor : SimpleBitstreamCursor {
   // bits.
   unsigned CurCodeSize = 2;
 
-  /// Abbrevs installed at in this block.
+  /// Abbrevs inherited from the block info for this block. They come first in
+  /// the abbrev ID space, followed by CurAbbrevs.
+  std::shared_ptr<const BitstreamBlockInfo::AbbrevList> CurBlockInfoAbbrevs;
+  unsigned CurNumBlockInfoAbbrevs = 0;
+
+  /// Abbrevs defined in this block.
   std::vector<std::shared_ptr<BitCodeAbbrev>> CurAbbrevs;
 
   struct Block {
     unsigned PrevCodeSize;
+    std::shared_ptr<const BitstreamBlockInfo::AbbrevList> PrevBlockInfoAbbrevs;
+    unsigned PrevNumBlockInfoAbbrevs;
     std::vector<std::shared_ptr<BitCodeAbbrev>> PrevAbbrevs;
 
-    explicit Block(unsigned PCS) : PrevCodeSize(PCS) {}
+    explicit Block(unsigned PCS)
+        : PrevCodeSize(PCS), PrevNumBlockInfoAbbrevs(0) {}
   };
 
   /// This tracks the codesize of parent blocks.
@@ -458,9 +470,12 @@ public:
 
 private:
   void popBlockScope() {
-    CurCodeSize = BlockScope.back().PrevCodeSize;
+    Block &Scope = BlockScope.back();
+    CurCodeSize = Scope.PrevCodeSize;
 
-    CurAbbrevs = std::move(BlockScope.back().PrevAbbrevs);
+    CurBlockInfoAbbrevs = std::move(Scope.PrevBlockInfoAbbrevs);
+    CurNumBlockInfoAbbrevs = Scope.PrevNumBlockInfoAbbrevs;
+    CurAbbrevs = std::move(Scope.PrevAbbrevs);
     BlockScope.pop_back();
   }
 
@@ -472,6 +487,9 @@ public:
   /// Return the abbreviation for the specified AbbrevId.
   const BitCodeAbbrev *getAbbrev(unsigned AbbrevID) {
     unsigned AbbrevNo = AbbrevID - bitc::FIRST_APPLICATION_ABBREV;
+    if (AbbrevNo < CurNumBlockInfoAbbrevs)
+      return (*CurBlockInfoAbbrevs)[AbbrevNo].get();
+    AbbrevNo -= CurNumBlockInfoAbbrevs;
     if (AbbrevNo >= CurAbbrevs.size())
       report_fatal_error("Invalid abbrev number");
     return CurAbbrevs[AbbrevNo].get();
@@ -405,6 +405,17 @@ public:
              ShouldEmitSize);
   }
 
+  /// Append whole 32-bit words that were encoded by another BitstreamWriter.
+  /// Both streams must be 32-bit aligned at that point, and the other stream
+  /// must have been in a block with the same abbrev ID width and block info,
+  /// so that the words decode the same way here.  This is used to splice in
+  /// blocks that were encoded concurrently.
+  void emitPreEncodedWords(StringRef Bytes) {
+    assert(CurBit == 0 && "Not 32-bit aligned");
+    assert((Bytes.size() & 3) == 0 && "Not a whole number of words");
+    Out.append(Bytes.begin(), Bytes.end());
+  }
+
   /// EmitRecord - Emit the specified record to the stream, using an abbrev if
   /// we have one to compress the output.
   template <typename Container>
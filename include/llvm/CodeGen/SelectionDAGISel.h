@@ -15,6 +15,7 @@
 #ifndef LLVM_CODEGEN_SELECTIONDAGISEL_H
 #define LLVM_CODEGEN_SELECTIONDAGISEL_H
 
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/CodeGen/MachineFunctionPass.h"
 #include "llvm/CodeGen/SelectionDAG.h"
 #include "llvm/CodeGen/TargetSubtargetInfo.h"
@@ -338,6 +339,15 @@ private:
   /// state machines that start with a OPC_SwitchOpcode node.
   std::vector<unsigned> OpcodeOffset;
 
+  /// SwitchCaseTables - This is a cache used to dispatch efficiently on
+  /// OPC_SwitchOpcode and OPC_SwitchType nodes with many cases, keyed by the
+  /// index of the switch in the matcher table.  Each table maps an opcode or
+  /// value type to the index of the first case that handles it, or 0.
+  DenseMap<unsigned, std::vector<unsigned>> SwitchCaseTables;
+
+  const std::vector<unsigned> &
+  getSwitchCaseTable(const unsigned char *MatcherTable, unsigned SwitchStart);
+
   void UpdateChains(SDNode *NodeToMatch, SDValue InputChain,
                     SmallVectorImpl<SDNode *> &ChainNodesMatched,
                     bool isMorphNodeTo);
@@ -19,8 +19,10 @@
 #ifndef LLVM_CODEGEN_SLOTINDEXES_H
 #define LLVM_CODEGEN_SLOTINDEXES_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/IntervalMap.h"
+#include "llvm/ADT/None.h"
 #include "llvm/ADT/PointerIntPair.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/ilist.h"
@@ -352,6 +354,16 @@ class raw_ostream;
     /// and MBB id.
     SmallVector<IdxMBBPair, 8> idx2MBBMap;
 
+    /// idx2MBBStarts - The idx2MBBMap start indexes as plain numbers, followed
+    /// by the number of the function's end index. Searching these doesn't load
+    /// an IndexListEntry for every probe, which is what makes block lookups in
+    /// large functions miss the cache. Kept in step by renumberIndexes.
+    SmallVector<unsigned, 8> idx2MBBStarts;
+
+    /// idx2MBBNumbers - The numbers of the idx2MBBMap blocks, in the same
+    /// order.
+    SmallVector<unsigned, 8> idx2MBBNumbers;
+
     IndexListEntry* createEntry(MachineInstr *mi, unsigned index) {
       IndexListEntry *entry =
           static_cast<IndexListEntry *>(ileAllocator.Allocate(
@@ -365,6 +377,21 @@ class raw_ostream;
     /// Renumber locally after inserting curItr.
     void renumberIndexes(IndexList::iterator curItr);
 
+    /// Rebuild idx2MBBStarts and idx2MBBNumbers from idx2MBBMap.
+    void packMBBIndexes();
+
+    /// Refresh the idx2MBBStarts entries whose numbers were in the range
+    /// (\p From, \p To] before a local renumbering.
+    void repackMBBIndexes(unsigned From, unsigned To);
+
+    /// Position of the first idx2MBBMap entry starting at or after \p Idx.
+    unsigned findMBBPosition(SlotIndex Idx, unsigned From = 0) const {
+      return std::lower_bound(idx2MBBStarts.begin() + From,
+                              idx2MBBStarts.begin() + idx2MBBMap.size(),
+                              Idx.getIndex()) -
+             idx2MBBStarts.begin();
+    }
+
   public:
     static char ID;
 
@@ -510,7 +537,7 @@ class raw_ostream;
     /// Move iterator to the next IdxMBBPair where the SlotIndex is greater or
     /// equal to \p To.
     MBBIndexIterator advanceMBBIndex(MBBIndexIterator I, SlotIndex To) const {
-      return std::lower_bound(I, idx2MBBMap.end(), To);
+      return idx2MBBMap.begin() + findMBBPosition(To, I - idx2MBBMap.begin());
     }
 
     /// Get an iterator pointing to the IdxMBBPair with the biggest SlotIndex
@@ -529,6 +556,21 @@ class raw_ostream;
       return idx2MBBMap.end();
     }
 
+    /// Returns the numbers of the basic blocks that lie entirely within
+    /// [\p Start, \p End], in layout order.
+    ArrayRef<unsigned> getMBBNumbersInRange(SlotIndex Start,
+                                            SlotIndex End) const {
+      unsigned First = findMBBPosition(Start);
+      unsigned Last = std::upper_bound(idx2MBBStarts.begin() + First,
+                                       idx2MBBStarts.end(), End.getIndex()) -
+                      idx2MBBStarts.begin();
+      // Block I ends where block I+1 starts, so blocks [First, Last-1) end by
+      // End.
+      if (Last <= First + 1)
+        return None;
+      return makeArrayRef(idx2MBBNumbers).slice(First, Last - 1 - First);
+    }
+
     /// Returns the basic block which the given index falls in.
     MachineBasicBlock* getMBBFromIndex(SlotIndex index) const {
       if (MachineInstr *MI = getInstructionFromIndex(index))
@@ -675,6 +717,7 @@ class raw_ostream;
 
       renumberIndexes(newItr);
       llvm::sort(idx2MBBMap.begin(), idx2MBBMap.end(), Idx2MBBCompare());
+      packMBBIndexes();
     }
 
     /// Free the resources that were required to maintain a SlotIndex.
@@ -1604,6 +1604,9 @@ public:
 
   /// Returns a \p outliner::OutlinedFunction struct containing target-specific
   /// information for a set of outlining candidates.
+  ///
+  /// The MachineOutliner calls this for several sets of candidates at once on
+  /// different threads, so it may only modify \p RepeatedSequenceLocs.
   virtual outliner::OutlinedFunction getOutliningCandidateInfo(
       std::vector<outliner::Candidate> &RepeatedSequenceLocs) const {
     llvm_unreachable(
@@ -84,6 +84,11 @@ public:
   BasicBlock &operator=(const BasicBlock &) = delete;
   ~BasicBlock();
 
+  /// Allocate a BasicBlock from the current ValueArena, if any.
+  void *operator new(size_t Size);
+  /// Free memory allocated for a BasicBlock.
+  void operator delete(void *Ptr);
+
   /// Get the context in which this basic block lives.
   LLVMContext &getContext() const;
 
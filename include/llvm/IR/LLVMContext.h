@@ -161,6 +161,17 @@ public:
   /// especially in release mode.
   void setDiscardValueNames(bool Discard);
 
+  /// Return true if instructions and basic blocks created inside a
+  /// ValueArenaScope (such as the bodies of lazily materialized functions) are
+  /// allocated from a recycling arena owned by the context.
+  bool shouldArenaAllocateFunctionBodies() const;
+
+  /// Set whether function bodies created inside a ValueArenaScope are
+  /// allocated from the context's arena. This improves locality and makes
+  /// freeing a function cheap, at the price of the arena only returning memory
+  /// to the system when the context is destroyed.
+  void setArenaAllocateFunctionBodies(bool Enable);
+
   /// Whether there is a string map for uniquing debug info
   /// identifiers across the context.  Off by default.
   bool isODRUniquingDebugTypes() const;
@@ -111,7 +111,7 @@ protected:
   ///
   /// Note, this should *NOT* be used directly by any class other than User.
   /// User uses this value to find the Use list.
-  enum : unsigned { NumUserOperandsBits = 28 };
+  enum : unsigned { NumUserOperandsBits = 27 };
   unsigned NumUserOperands : NumUserOperandsBits;
 
   // Use the same type as the bitfield above so that MSVC will pack them.
@@ -120,6 +120,11 @@ protected:
   unsigned HasHungOffUses : 1;
   unsigned HasDescriptor : 1;
 
+  /// Set if the storage of this value was obtained from a ValueArena. Like the
+  /// operand bookkeeping above, this is not initialized by the constructor; it
+  /// is only meaningful for User and BasicBlock, whose operator new sets it.
+  unsigned IsArenaAllocated : 1;
+
 private:
   template <typename UseT> // UseT == 'Use' or 'const Use'
   class use_iterator_impl
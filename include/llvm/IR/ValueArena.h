@@ -0,0 +1,114 @@
+//===- llvm/IR/ValueArena.h - Recycling arena for IR values -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+/// \file
+/// This file declares ValueArena, a recycling bump allocator that can back the
+/// storage of Users (including their co-allocated and hung-off Use arrays) and
+/// BasicBlocks, and ValueArenaScope, which routes such allocations made on the
+/// current thread to the arena owned by an LLVMContext.
+///
+/// Function bodies allocated this way are laid out next to each other instead
+/// of being scattered across the heap, and deleting a function returns its
+/// storage to per-size free lists that the next materialized function reuses.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IR_VALUEARENA_H
+#define LLVM_IR_VALUEARENA_H
+
+#include "llvm/Support/Allocator.h"
+#include <cstddef>
+
+namespace llvm {
+
+class LLVMContext;
+
+class ValueArena {
+  /// Prefix of every block handed out by the arena. It lets deallocate() find
+  /// the owning arena and the size class without any help from the caller.
+  struct BlockHeader {
+    ValueArena *Owner;
+    size_t Size;
+  };
+
+  /// Recycled blocks are threaded through their first word.
+  struct FreeBlock {
+    FreeBlock *Next;
+  };
+
+  /// Sizes are rounded up to this granularity so that a recycled block can
+  /// serve any request of the same size class.
+  static constexpr size_t SizeClassGranularity = 16;
+  /// Blocks larger than NumSizeClasses * SizeClassGranularity bytes (big
+  /// switches, calls with many arguments, the operand lists of large PHIs)
+  /// come from the global heap and go straight back to it when freed, so that
+  /// they do not pile up in the slabs.
+  static constexpr unsigned NumSizeClasses = 32;
+  static constexpr size_t MaxSlabBlockSize =
+      NumSizeClasses * SizeClassGranularity;
+
+  BumpPtrAllocator Allocator;
+  FreeBlock *FreeLists[NumSizeClasses] = {};
+  size_t BytesInUse = 0;
+  size_t NumRecycled = 0;
+
+  static BlockHeader *getHeader(void *Ptr) {
+    return static_cast<BlockHeader *>(Ptr) - 1;
+  }
+
+public:
+  ValueArena() = default;
+  ValueArena(const ValueArena &) = delete;
+  ValueArena &operator=(const ValueArena &) = delete;
+
+  /// Allocate \p Size bytes aligned to at least alignof(void *).
+  void *allocate(size_t Size);
+
+  /// Return a block obtained from allocate() to the arena that owns it.
+  static void deallocate(void *Ptr);
+
+  /// Return the arena that owns the block \p Ptr obtained from allocate().
+  static ValueArena *getOwner(void *Ptr) { return getHeader(Ptr)->Owner; }
+
+  /// Return the arena that User and BasicBlock allocations on the current
+  /// thread are routed to, or null if they use the global heap.
+  static ValueArena *getCurrent();
+
+  /// Total number of bytes the arena has obtained from the system for its
+  /// slabs. Oversized blocks are not included.
+  size_t getTotalMemory() const { return Allocator.getTotalMemory(); }
+
+  /// Number of bytes (including block headers) currently handed out.
+  size_t getBytesInUse() const { return BytesInUse; }
+
+  /// Number of allocations that were served from a free list.
+  size_t getNumRecycled() const { return NumRecycled; }
+};
+
+/// RAII object that routes User and BasicBlock allocations made on the current
+/// thread to the arena of an LLVMContext for its lifetime, provided the
+/// context has opted in with LLVMContext::setArenaAllocateFunctionBodies.
+/// Otherwise allocations inside the scope use the global heap, even if an
+/// enclosing scope installed another context's arena.
+///
+/// Everything allocated inside the scope must belong to that context, since
+/// its storage is only valid as long as the context is alive.
+class ValueArenaScope {
+  ValueArena *SavedArena;
+
+public:
+  explicit ValueArenaScope(LLVMContext &Context);
+  ValueArenaScope(const ValueArenaScope &) = delete;
+  ValueArenaScope &operator=(const ValueArenaScope &) = delete;
+  ~ValueArenaScope();
+};
+
+} // end namespace llvm
+
+#endif // LLVM_IR_VALUEARENA_H
@@ -12,6 +12,7 @@
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallVector.h"
+#include <memory>
 
 namespace llvm {
 class MCAssembler;
@@ -44,8 +45,15 @@ class MCAsmLayout {
   /// Is the layout for this fragment valid?
   bool isFragmentValid(const MCFragment *F) const;
 
+  /// Relaxation bookkeeping for a single section, see getFragmentsToRelax().
+  struct SectionRelaxState;
+  DenseMap<const MCSection *, std::unique_ptr<SectionRelaxState>> RelaxStates;
+
+  SectionRelaxState &getRelaxState(MCSection &Sec);
+
 public:
   MCAsmLayout(MCAssembler &Assembler);
+  ~MCAsmLayout();
 
   /// Get the assembler object this is a layout for.
   MCAssembler &getAssembler() const { return Assembler; }
@@ -60,6 +68,22 @@ public:
   /// been initialized.
   void layoutFragment(MCFragment *Fragment);
 
+  /// \name Relaxation Bookkeeping
+  /// @{
+
+  /// Start a relaxation pass over \p Sec and collect, in layout order, the
+  /// fragments that have to be checked during it. The first pass checks every
+  /// fragment that can be relaxed. Later passes skip a fragment whose fixups
+  /// are PC-relative references into \p Sec when no fragment between it and
+  /// its targets changed size in the previous pass.
+  void getFragmentsToRelax(MCSection &Sec,
+                           SmallVectorImpl<MCFragment *> &Fragments);
+
+  /// Record that \p F changed size during the current relaxation pass.
+  void noteFragmentRelaxed(const MCFragment *F);
+
+  /// @}
+
   /// \name Section Access (in layout order)
   /// @{
 
@@ -46,11 +46,14 @@ public:
   size_t add(StringRef S) { return add(CachedHashStringRef(S)); }
 
   /// Analyze the strings and build the final table. No more strings can
-  /// be added after this point.
+  /// be added after this point. A string that is a suffix of another string
+  /// shares its storage; large tables are sorted on several threads to find
+  /// those.
   void finalize();
 
   /// Finalize the string table without reording it. In this mode, offsets
-  /// returned by add will still be valid.
+  /// returned by add will still be valid. Strings are only deduplicated, which
+  /// is much cheaper than finalize for tables with millions of strings.
   void finalizeInOrder();
 
   /// Get the offest of a string in the string table. Can only be used
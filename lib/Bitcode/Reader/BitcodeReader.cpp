@@ -59,6 +59,7 @@
 #include "llvm/IR/Operator.h"
 #include "llvm/IR/Type.h"
 #include "llvm/IR/Value.h"
+#include "llvm/IR/ValueArena.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/AtomicOrdering.h"
 #include "llvm/Support/Casting.h"
@@ -4711,8 +4712,12 @@ Error BitcodeReader::materialize(GlobalValue *GV) {
   // Move the bit stream to the saved position of the deferred function body.
   Stream.JumpToBit(DFII->second);
 
-  if (Error Err = parseFunctionBody(F))
-    return Err;
+  {
+    // Keep the new body together in the context's arena, if it has one.
+    ValueArenaScope ArenaScope(Context);
+    if (Error Err = parseFunctionBody(F))
+      return Err;
+  }
   F->setIsMaterializable(false);
 
   if (StripDebugInfo)
@@ -23,14 +23,20 @@ using namespace llvm;
 bool BitstreamCursor::EnterSubBlock(unsigned BlockID, unsigned *NumWordsP) {
   // Save the current block's state on BlockScope.
   BlockScope.push_back(Block(CurCodeSize));
-  BlockScope.back().PrevAbbrevs.swap(CurAbbrevs);
-
-  // Add the abbrevs specific to this block to the CurAbbrevs list.
+  Block &Scope = BlockScope.back();
+  Scope.PrevBlockInfoAbbrevs = std::move(CurBlockInfoAbbrevs);
+  Scope.PrevNumBlockInfoAbbrevs = CurNumBlockInfoAbbrevs;
+  Scope.PrevAbbrevs.swap(CurAbbrevs);
+
+  // Install the abbrevs specific to this block. The list is shared with the
+  // block info rather than copied.
+  CurBlockInfoAbbrevs = nullptr;
+  CurNumBlockInfoAbbrevs = 0;
   if (BlockInfo) {
     if (const BitstreamBlockInfo::BlockInfo *Info =
             BlockInfo->getBlockInfo(BlockID)) {
-      CurAbbrevs.insert(CurAbbrevs.end(), Info->Abbrevs.begin(),
-                        Info->Abbrevs.end());
+      CurBlockInfoAbbrevs = Info->Abbrevs;
+      CurNumBlockInfoAbbrevs = Info->Abbrevs->size();
     }
   }
 
@@ -351,7 +357,7 @@ BitstreamCursor::ReadBlockInfoBlock(bool ReadBlockInfoNames) {
 
       // ReadAbbrevRecord installs the abbrev in CurAbbrevs.  Move it to the
       // appropriate BlockInfo.
-      CurBlockInfo->Abbrevs.push_back(std::move(CurAbbrevs.back()));
+      CurBlockInfo->Abbrevs->push_back(std::move(CurAbbrevs.back()));
       CurAbbrevs.pop_back();
       continue;
     }
@@ -90,6 +90,8 @@ using namespace llvm;
 STATISTIC(NumMDStringLoaded, "Number of MDStrings loaded");
 STATISTIC(NumMDNodeTemporary, "Number of MDNode::Temporary created");
 STATISTIC(NumMDRecordLoaded, "Number of Metadata records loaded");
+STATISTIC(NumCUListsSkipped,
+          "Number of DICompileUnit lists not loaded when importing");
 
 /// Flag whether we need to import full type definitions for ThinLTO.
 /// Currently needed for Darwin and LLDB.
@@ -1381,15 +1383,28 @@ Error MetadataLoader::MetadataLoaderImpl::parseOneMetadata(
     if (Record.size() < 14 || Record.size() > 19)
       return error("Invalid record");
 
+    // When importing for ThinLTO, the enums, retained types, globals and
+    // macros listed on the compile unit are dropped by the IRMover (see
+    // IRLinker::prepareCompileUnitsForImport). Don't load them at all: with
+    // on-demand loading they are the only path from an imported function's
+    // subprogram to the debug info of the rest of the module.
+    auto getCUListOrNull = [&](unsigned ID) -> Metadata * {
+      if (!IsImporting)
+        return getMDOrNull(ID);
+      if (ID)
+        ++NumCUListsSkipped;
+      return nullptr;
+    };
+
     // Ignore Record[0], which indicates whether this compile unit is
     // distinct.  It's always distinct.
     IsDistinct = true;
     auto *CU = DICompileUnit::getDistinct(
         Context, Record[1], getMDOrNull(Record[2]), getMDString(Record[3]),
         Record[4], getMDString(Record[5]), Record[6], getMDString(Record[7]),
-        Record[8], getMDOrNull(Record[9]), getMDOrNull(Record[10]),
-        getMDOrNull(Record[12]), getMDOrNull(Record[13]),
-        Record.size() <= 15 ? nullptr : getMDOrNull(Record[15]),
+        Record[8], getCUListOrNull(Record[9]), getCUListOrNull(Record[10]),
+        getCUListOrNull(Record[12]), getMDOrNull(Record[13]),
+        Record.size() <= 15 ? nullptr : getCUListOrNull(Record[15]),
         Record.size() <= 14 ? 0 : Record[14],
         Record.size() <= 16 ? true : Record[16],
         Record.size() <= 17 ? false : Record[17],
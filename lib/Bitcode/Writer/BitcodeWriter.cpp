@@ -68,8 +68,10 @@
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/SHA1.h"
 #include "llvm/Support/TargetRegistry.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -87,6 +89,11 @@ static cl::opt<unsigned>
                    cl::desc("Number of metadatas above which we emit an index "
                             "to enable lazy-loading"));
 
+static cl::opt<unsigned> WriterThreads(
+    "bitcode-writer-threads", cl::Hidden, cl::init(1),
+    cl::desc("Number of threads used to encode function blocks. The output "
+             "does not depend on this value"));
+
 cl::opt<bool> WriteRelBFToSummary(
     "write-relbf-to-summary", cl::Hidden, cl::init(false),
     cl::desc("Write relative block frequency to function summary "));
@@ -384,6 +391,9 @@ private:
   void
   writeFunction(const Function &F,
                 DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
+  void writeFunctionsInParallel(
+      ArrayRef<const Function *> Functions, unsigned NumThreads,
+      DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex);
   void writeBlockInfo();
   void writeModuleHash(size_t BlockStartPos);
 
@@ -3109,6 +3119,64 @@ void ModuleBitcodeWriter::writeFunction(
   Stream.ExitBlock();
 }
 
+/// Encode the blocks of \p Functions on \p NumThreads threads and splice them
+/// into the stream in order, producing the same bits as calling writeFunction
+/// on each of them.
+///
+/// Once the module-level tables are written, a function block only depends on
+/// the value numbering and on the block info abbreviations, and it starts and
+/// ends on a word boundary. Each thread therefore rebuilds both in a private
+/// ModuleBitcodeWriter (at the cost of one ValueEnumerator per thread), encodes
+/// the functions it picks into its own buffer, and the words are copied out
+/// once all threads are done.
+void ModuleBitcodeWriter::writeFunctionsInParallel(
+    ArrayRef<const Function *> Functions, unsigned NumThreads,
+    DenseMap<const Function *, uint64_t> &FunctionToBitcodeIndex) {
+  // Arguments are created lazily. Create them here so that the threads below
+  // only ever read the module.
+  for (const Function *F : Functions)
+    (void)F->arg_begin();
+
+  struct EncodedBlock {
+    unsigned Thread;
+    size_t Begin, End;
+  };
+  std::vector<EncodedBlock> Blocks(Functions.size());
+  std::vector<SmallVector<char, 0>> Buffers(NumThreads);
+  std::atomic<size_t> NextFunction(0);
+
+  ThreadPool Pool(NumThreads);
+  for (unsigned Thread = 0; Thread != NumThreads; ++Thread)
+    Pool.async([&, Thread] {
+      SmallVector<char, 0> &Buffer = Buffers[Thread];
+      BitstreamWriter ThreadStream(Buffer);
+      StringTableBuilder UnusedStrtab(StringTableBuilder::RAW);
+      ModuleBitcodeWriter ThreadWriter(M, Buffer, UnusedStrtab, ThreadStream,
+                                       /*ShouldPreserveUseListOrder=*/false,
+                                       /*Index=*/nullptr,
+                                       /*GenerateHash=*/false);
+      ThreadStream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
+      ThreadWriter.writeBlockInfo();
+
+      DenseMap<const Function *, uint64_t> UnusedBitcodeIndex;
+      for (size_t I = NextFunction++; I < Functions.size();
+           I = NextFunction++) {
+        size_t Begin = Buffer.size();
+        ThreadWriter.writeFunction(*Functions[I], UnusedBitcodeIndex);
+        Blocks[I] = {Thread, Begin, Buffer.size()};
+      }
+      ThreadStream.ExitBlock();
+    });
+  Pool.wait();
+
+  for (size_t I = 0, E = Functions.size(); I != E; ++I) {
+    const EncodedBlock &Block = Blocks[I];
+    FunctionToBitcodeIndex[Functions[I]] = Stream.GetCurrentBitNo();
+    Stream.emitPreEncodedWords(StringRef(
+        Buffers[Block.Thread].data() + Block.Begin, Block.End - Block.Begin));
+  }
+}
+
 // Emit blockinfo, which defines the standard abbreviations etc.
 void ModuleBitcodeWriter::writeBlockInfo() {
   // We only want to emit block info records for blocks that have multiple
@@ -3977,8 +4045,19 @@ void ModuleBitcodeWriter::write() {
 
   // Emit function bodies.
   DenseMap<const Function *, uint64_t> FunctionToBitcodeIndex;
-  for (Module::const_iterator F = M.begin(), E = M.end(); F != E; ++F)
-    if (!F->isDeclaration())
+  std::vector<const Function *> FunctionsWithBodies;
+  for (const Function &F : M)
+    if (!F.isDeclaration())
+      FunctionsWithBodies.push_back(&F);
+  // Use-list orders are consumed from a single stack in module order, so they
+  // force serial emission.
+  unsigned NumThreads = std::min<size_t>(WriterThreads,
+                                         FunctionsWithBodies.size());
+  if (NumThreads > 1 && !VE.shouldPreserveUseListOrder())
+    writeFunctionsInParallel(FunctionsWithBodies, NumThreads,
+                             FunctionToBitcodeIndex);
+  else
+    for (const Function *F : FunctionsWithBodies)
       writeFunction(*F, FunctionToBitcodeIndex);
 
   // Need to write after the above call to WriteFunction which populates
@@ -11,7 +11,7 @@
 /// Replaces repeated sequences of instructions with function calls.
 ///
 /// This works by placing every instruction from every basic block in a
-/// suffix tree, and repeatedly querying that tree for repeated sequences of
+/// suffix array, and querying that array for repeated sequences of
 /// instructions. If a sequence of instructions appears often, then it ought
 /// to be beneficial to pull out into a function.
 ///
@@ -43,20 +43,21 @@
 ///
 /// The talk provides an overview of how the outliner finds candidates and
 /// ultimately outlines them. It describes how the main data structure for this
-/// pass, the suffix tree, is queried and purged for candidates. It also gives
-/// a simplified suffix tree construction algorithm for suffix trees based off
-/// of the algorithm actually used here, Ukkonen's algorithm.
+/// pass, the suffix tree, is queried and purged for candidates. This pass
+/// uses a suffix array with an LCP array, which describes the same repeated
+/// sequences in much less memory.
 ///
 /// For the original RFC for this pass, please see
 ///
 /// http://lists.llvm.org/pipermail/llvm-dev/2016-August/104170.html
 ///
-/// For more information on the suffix tree data structure, please see
-/// https://www.cs.helsinki.fi/u/ukkonen/SuffixT1withFigs.pdf
+/// For more information on replacing suffix trees with suffix arrays, please
+/// see https://doi.org/10.1016/S1570-8667(03)00065-0
 ///
 //===----------------------------------------------------------------------===//
 #include "llvm/CodeGen/MachineOutliner.h"
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/CodeGen/MachineFunction.h"
@@ -72,6 +73,7 @@
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 #include <functional>
 #include <map>
@@ -101,422 +103,210 @@ static cl::opt<bool> EnableLinkOnceODROutlining(
 
 namespace {
 
-/// Represents an undefined index in the suffix tree.
-const unsigned EmptyIdx = -1;
-
-/// A node in a suffix tree which represents a substring or suffix.
-///
-/// Each node has either no children or at least two children, with the root
-/// being a exception in the empty tree.
-///
-/// Children are represented as a map between unsigned integers and nodes. If
-/// a node N has a child M on unsigned integer k, then the mapping represented
-/// by N is a proper prefix of the mapping represented by M. Note that this,
-/// although similar to a trie is somewhat different: each node stores a full
-/// substring of the full mapping rather than a single character state.
-///
-/// Each internal node contains a pointer to the internal node representing
-/// the same string, but with the first character chopped off. This is stored
-/// in \p Link. Each leaf node stores the start index of its respective
-/// suffix in \p SuffixIdx.
-struct SuffixTreeNode {
-
-  /// The children of this node.
-  ///
-  /// A child existing on an unsigned integer implies that from the mapping
-  /// represented by the current node, there is a way to reach another
-  /// mapping by tacking that character on the end of the current string.
-  DenseMap<unsigned, SuffixTreeNode *> Children;
-
-  /// A flag set to false if the node has been pruned from the tree.
-  bool IsInTree = true;
-
-  /// The start index of this node's substring in the main string.
-  unsigned StartIdx = EmptyIdx;
-
-  /// The end index of this node's substring in the main string.
-  ///
-  /// Every leaf node must have its \p EndIdx incremented at the end of every
-  /// step in the construction algorithm. To avoid having to update O(N)
-  /// nodes individually at the end of every step, the end index is stored
-  /// as a pointer.
-  unsigned *EndIdx = nullptr;
-
-  /// For leaves, the start index of the suffix represented by this node.
-  ///
-  /// For all other nodes, this is ignored.
-  unsigned SuffixIdx = EmptyIdx;
-
-  /// For internal nodes, a pointer to the internal node representing
-  /// the same sequence with the first character chopped off.
-  ///
-  /// This acts as a shortcut in Ukkonen's algorithm. One of the things that
-  /// Ukkonen's algorithm does to achieve linear-time construction is
-  /// keep track of which node the next insert should be at. This makes each
-  /// insert O(1), and there are a total of O(N) inserts. The suffix link
-  /// helps with inserting children of internal nodes.
-  ///
-  /// Say we add a child to an internal node with associated mapping S. The
-  /// next insertion must be at the node representing S - its first character.
-  /// This is given by the way that we iteratively build the tree in Ukkonen's
-  /// algorithm. The main idea is to look at the suffixes of each prefix in the
-  /// string, starting with the longest suffix of the prefix, and ending with
-  /// the shortest. Therefore, if we keep pointers between such nodes, we can
-  /// move to the next insertion point in O(1) time. If we don't, then we'd
-  /// have to query from the root, which takes O(N) time. This would make the
-  /// construction algorithm O(N^2) rather than O(N).
-  SuffixTreeNode *Link = nullptr;
-
-  /// The parent of this node. Every node except for the root has a parent.
-  SuffixTreeNode *Parent = nullptr;
-
-  /// The number of times this node's string appears in the tree.
-  ///
-  /// This is equal to the number of leaf children of the string. It represents
-  /// the number of suffixes that the node's string is a prefix of.
-  unsigned OccurrenceCount = 0;
-
-  /// The length of the string formed by concatenating the edge labels from the
-  /// root to this node.
-  unsigned ConcatLen = 0;
-
-  /// Returns true if this node is a leaf.
-  bool isLeaf() const { return SuffixIdx != EmptyIdx; }
-
-  /// Returns true if this node is the root of its owning \p SuffixTree.
-  bool isRoot() const { return StartIdx == EmptyIdx; }
-
-  /// Return the number of elements in the substring associated with this node.
-  size_t size() const {
-
-    // Is it the root? If so, it's the empty string so return 0.
-    if (isRoot())
-      return 0;
-
-    assert(*EndIdx != EmptyIdx && "EndIdx is undefined!");
-
-    // Size = the number of elements in the string.
-    // For example, [0 1 2 3] has length 4, not 3. 3-0 = 3, so we have 3-0+1.
-    return *EndIdx - StartIdx + 1;
-  }
-
-  SuffixTreeNode(unsigned StartIdx, unsigned *EndIdx, SuffixTreeNode *Link,
-                 SuffixTreeNode *Parent)
-      : StartIdx(StartIdx), EndIdx(EndIdx), Link(Link), Parent(Parent) {}
-
-  SuffixTreeNode() {}
-};
-
-/// A data structure for fast substring queries.
+/// A data structure for finding repeated substrings.
 ///
-/// Suffix trees represent the suffixes of their input strings in their leaves.
-/// A suffix tree is a type of compressed trie structure where each node
-/// represents an entire substring rather than a single character. Each leaf
-/// of the tree is a suffix.
-///
-/// A suffix tree can be seen as a type of state machine where each state is a
-/// substring of the full string. The tree is structured so that, for a string
-/// of length N, there are exactly N leaves in the tree. This structure allows
-/// us to quickly find repeated substrings of the input string.
+/// A suffix array is the list of the start indices of the suffixes of a
+/// string, in lexicographic order of the suffixes. Together with the length
+/// of the longest common prefix of each pair of adjacent suffixes (the LCP
+/// array), it describes the same repeats as a suffix tree: every internal
+/// node of the suffix tree is a range of adjacent suffixes whose common prefix
+/// is longer than that of the suffixes around the range. The suffix array
+/// takes a few unsigned integers per character of the string, which is much
+/// less than a suffix tree with a child map for every node.
 ///
 /// In this implementation, a "string" is a vector of unsigned integers.
-/// These integers may result from hashing some data type. A suffix tree can
-/// contain 1 or many strings, which can then be queried as one large string.
-///
-/// The suffix tree is implemented using Ukkonen's algorithm for linear-time
-/// suffix tree construction. Ukkonen's algorithm is explained in more detail
-/// in the paper by Esko Ukkonen "On-line construction of suffix trees. The
-/// paper is available at
+/// These integers may result from hashing some data type. Every suffix of the
+/// string must be unique, which the outliner guarantees by ending the mapping
+/// of every basic block with a unique integer.
 ///
-/// https://www.cs.helsinki.fi/u/ukkonen/SuffixT1withFigs.pdf
-class SuffixTree {
+/// The suffix array is sorted by prefix doubling: the suffixes are first
+/// ranked by their first character, and then by their first 2, 4, 8, ...
+/// characters until all ranks are distinct. Each step is a linear bucket
+/// sort, and the number of steps is logarithmic in the length of the longest
+/// repeated substring. The LCP array is computed with Kasai's algorithm, and
+/// the repeats are then enumerated with a single scan over it; see
+/// "Replacing suffix trees with enhanced suffix arrays" by Abouelhoda,
+/// Kurtz and Ohlebusch.
+class SuffixArray {
 public:
-  /// Stores each leaf node in the tree.
+  /// A repeated substring, represented by the suffixes that branch off the
+  /// corresponding suffix tree node directly.
   ///
-  /// This is used for finding outlining candidates.
-  std::vector<SuffixTreeNode *> LeafVector;
+  /// The other occurrences of the substring are prefixes of longer repeated
+  /// substrings, which are represented by their own \p RepeatedSubstring.
+  struct RepeatedSubstring {
+    /// The length of the substring.
+    unsigned Length;
+
+    /// The range of \p StartIndices holding the occurrences of the substring.
+    unsigned Begin, End;
+  };
 
   /// Each element is an integer representing an instruction in the module.
   ArrayRef<unsigned> Str;
 
-private:
-  /// Maintains each node in the tree.
-  SpecificBumpPtrAllocator<SuffixTreeNode> NodeAllocator;
-
-  /// The root of the suffix tree.
-  ///
-  /// The root represents the empty string. It is maintained by the
-  /// \p NodeAllocator like every other node in the tree.
-  SuffixTreeNode *Root = nullptr;
-
-  /// Maintains the end indices of the internal nodes in the tree.
-  ///
-  /// Each internal node is guaranteed to never have its end index change
-  /// during the construction algorithm; however, leaves must be updated at
-  /// every step. Therefore, we need to store leaf end indices by reference
-  /// to avoid updating O(N) leaves at every step of construction. Thus,
-  /// every internal node must be allocated its own end index.
-  BumpPtrAllocator InternalEndIdxAllocator;
-
-  /// The end index of each leaf in the tree.
-  unsigned LeafEndIdx = -1;
-
-  /// Helper struct which keeps track of the next insertion point in
-  /// Ukkonen's algorithm.
-  struct ActiveState {
-    /// The next node to insert at.
-    SuffixTreeNode *Node;
-
-    /// The index of the first character in the substring currently being added.
-    unsigned Idx = EmptyIdx;
-
-    /// The length of the substring we have to add at the current step.
-    unsigned Len = 0;
-  };
-
-  /// The point the next insertion will take place at in the
-  /// construction algorithm.
-  ActiveState Active;
-
-  /// Allocate a leaf node and add it to the tree.
-  ///
-  /// \param Parent The parent of this node.
-  /// \param StartIdx The start index of this node's associated string.
-  /// \param Edge The label on the edge leaving \p Parent to this node.
-  ///
-  /// \returns A pointer to the allocated leaf node.
-  SuffixTreeNode *insertLeaf(SuffixTreeNode &Parent, unsigned StartIdx,
-                             unsigned Edge) {
+  /// The repeated substrings of \p Str which occur at least twice as a suffix
+  /// tree leaf, in increasing order of their first start index.
+  std::vector<RepeatedSubstring> RepeatedSubstrings;
 
-    assert(StartIdx <= LeafEndIdx && "String can't start after it ends!");
+  /// The start indices of the occurrences of each repeated substring, in
+  /// increasing order.
+  std::vector<unsigned> StartIndices;
 
-    SuffixTreeNode *N = new (NodeAllocator.Allocate())
-        SuffixTreeNode(StartIdx, &LeafEndIdx, nullptr, &Parent);
-    Parent.Children[Edge] = N;
-
-    return N;
+  /// Return the start indices of the occurrences of \p RS.
+  ArrayRef<unsigned> getStartIndices(const RepeatedSubstring &RS) const {
+    return makeArrayRef(StartIndices).slice(RS.Begin, RS.End - RS.Begin);
   }
 
-  /// Allocate an internal node and add it to the tree.
-  ///
-  /// \param Parent The parent of this node. Only null when allocating the root.
-  /// \param StartIdx The start index of this node's associated string.
-  /// \param EndIdx The end index of this node's associated string.
-  /// \param Edge The label on the edge leaving \p Parent to this node.
-  ///
-  /// \returns A pointer to the allocated internal node.
-  SuffixTreeNode *insertInternalNode(SuffixTreeNode *Parent, unsigned StartIdx,
-                                     unsigned EndIdx, unsigned Edge) {
-
-    assert(StartIdx <= EndIdx && "String can't start after it ends!");
-    assert(!(!Parent && StartIdx != EmptyIdx) &&
-           "Non-root internal nodes must have parents!");
-
-    unsigned *E = new (InternalEndIdxAllocator) unsigned(EndIdx);
-    SuffixTreeNode *N = new (NodeAllocator.Allocate())
-        SuffixTreeNode(StartIdx, E, Root, Parent);
-    if (Parent)
-      Parent->Children[Edge] = N;
-
-    return N;
-  }
-
-  /// Set the suffix indices of the leaves to the start indices of their
-  /// respective suffixes. Also stores each leaf in \p LeafVector at its
-  /// respective suffix index.
-  ///
-  /// \param[in] CurrNode The node currently being visited.
-  /// \param CurrIdx The current index of the string being visited.
-  void setSuffixIndices(SuffixTreeNode &CurrNode, unsigned CurrIdx) {
-
-    bool IsLeaf = CurrNode.Children.size() == 0 && !CurrNode.isRoot();
-
-    // Store the length of the concatenation of all strings from the root to
-    // this node.
-    if (!CurrNode.isRoot()) {
-      if (CurrNode.ConcatLen == 0)
-        CurrNode.ConcatLen = CurrNode.size();
-
-      if (CurrNode.Parent)
-        CurrNode.ConcatLen += CurrNode.Parent->ConcatLen;
-    }
-
-    // Traverse the tree depth-first.
-    for (auto &ChildPair : CurrNode.Children) {
-      assert(ChildPair.second && "Node had a null child!");
-      setSuffixIndices(*ChildPair.second, CurrIdx + ChildPair.second->size());
+private:
+  /// Sort the suffixes of \p Str into \p SA, and set \p Rank to the inverse
+  /// permutation.
+  void sortSuffixes(std::vector<unsigned> &SA, std::vector<unsigned> &Rank) {
+    unsigned N = Str.size();
+    SA.resize(N);
+    Rank.resize(N);
+    for (unsigned I = 0; I != N; ++I)
+      SA[I] = I;
+    parallel::sort(parallel::par, SA.begin(), SA.end(),
+                   [this](unsigned L, unsigned R) { return Str[L] < Str[R]; });
+
+    // The rank of a suffix is the position of the first suffix which is equal
+    // to it on the characters compared so far. That is the position where its
+    // bucket starts in the next step.
+    unsigned NumRanks = 0;
+    for (unsigned I = 0; I != N; ++I) {
+      bool NewRank = I == 0 || Str[SA[I]] != Str[SA[I - 1]];
+      Rank[SA[I]] = NewRank ? I : Rank[SA[I - 1]];
+      NumRanks += NewRank;
     }
 
-    // Is this node a leaf?
-    if (IsLeaf) {
-      // If yes, give it a suffix index and bump its parent's occurrence count.
-      CurrNode.SuffixIdx = Str.size() - CurrIdx;
-      assert(CurrNode.Parent && "CurrNode had no parent!");
-      CurrNode.Parent->OccurrenceCount++;
-
-      // Store the leaf in the leaf vector for pruning later.
-      LeafVector[CurrNode.SuffixIdx] = &CurrNode;
+    std::vector<unsigned> Tmp(N), Next(N);
+    for (unsigned K = 1; NumRanks != N; K *= 2) {
+      // Order the suffixes by their characters [K, 2K). Suffixes shorter
+      // than K + 1 characters come first since they have none.
+      unsigned Pos = 0;
+      for (unsigned I = N - std::min(K, N); I != N; ++I)
+        Tmp[Pos++] = I;
+      for (unsigned I : SA)
+        if (I >= K)
+          Tmp[Pos++] = I - K;
+
+      // Stable bucket sort by the ranks of their first K characters.
+      for (unsigned I = 0; I != N; ++I)
+        Next[I] = I;
+      for (unsigned I : Tmp)
+        SA[Next[Rank[I]]++] = I;
+
+      // Rank them by their first 2K characters.
+      auto SecondRank = [&](unsigned I) { return I + K < N ? Rank[I + K] : N; };
+      NumRanks = 0;
+      for (unsigned I = 0; I != N; ++I) {
+        bool NewRank = I == 0 || Rank[SA[I]] != Rank[SA[I - 1]] ||
+                       SecondRank(SA[I]) != SecondRank(SA[I - 1]);
+        Tmp[SA[I]] = NewRank ? I : Tmp[SA[I - 1]];
+        NumRanks += NewRank;
+      }
+      std::swap(Rank, Tmp);
     }
   }
 
-  /// Construct the suffix tree for the prefix of the input ending at
-  /// \p EndIdx.
-  ///
-  /// Used to construct the full suffix tree iteratively. At the end of each
-  /// step, the constructed suffix tree is either a valid suffix tree, or a
-  /// suffix tree with implicit suffixes. At the end of the final step, the
-  /// suffix tree is a valid tree.
-  ///
-  /// \param EndIdx The end index of the current prefix in the main string.
-  /// \param SuffixesToAdd The number of suffixes that must be added
-  /// to complete the suffix tree at the current phase.
-  ///
-  /// \returns The number of suffixes that have not been added at the end of
-  /// this step.
-  unsigned extend(unsigned EndIdx, unsigned SuffixesToAdd) {
-    SuffixTreeNode *NeedsLink = nullptr;
-
-    while (SuffixesToAdd > 0) {
+  /// Set \p LCP[I] to the length of the longest common prefix of the suffixes
+  /// at \p SA[I - 1] and \p SA[I], and \p LCP[0] to 0.
+  void computeLCP(ArrayRef<unsigned> SA, ArrayRef<unsigned> Rank,
+                  std::vector<unsigned> &LCP) {
+    unsigned N = Str.size();
+    LCP.assign(N, 0);
 
-      // Are we waiting to add anything other than just the last character?
-      if (Active.Len == 0) {
-        // If not, then say the active index is the end index.
-        Active.Idx = EndIdx;
+    // The common prefix of a suffix with its predecessor is at most one
+    // character shorter than that of the previous suffix in the string.
+    unsigned Len = 0;
+    for (unsigned I = 0; I != N; ++I) {
+      if (Rank[I] == 0) {
+        Len = 0;
+        continue;
       }
+      unsigned J = SA[Rank[I] - 1];
+      while (I + Len < N && J + Len < N && Str[I + Len] == Str[J + Len])
+        ++Len;
+      LCP[Rank[I]] = Len;
+      if (Len > 0)
+        --Len;
+    }
+  }
 
-      assert(Active.Idx <= EndIdx && "Start index can't be after end index!");
-
-      // The first character in the current substring we're looking at.
-      unsigned FirstChar = Str[Active.Idx];
-
-      // Have we inserted anything starting with FirstChar at the current node?
-      if (Active.Node->Children.count(FirstChar) == 0) {
-        // If not, then we can just insert a leaf and move too the next step.
-        insertLeaf(*Active.Node, EndIdx, FirstChar);
-
-        // The active node is an internal node, and we visited it, so it must
-        // need a link if it doesn't have one.
-        if (NeedsLink) {
-          NeedsLink->Link = Active.Node;
-          NeedsLink = nullptr;
-        }
-      } else {
-        // There's a match with FirstChar, so look for the point in the tree to
-        // insert a new node.
-        SuffixTreeNode *NextNode = Active.Node->Children[FirstChar];
-
-        unsigned SubstringLen = NextNode->size();
-
-        // Is the current suffix we're trying to insert longer than the size of
-        // the child we want to move to?
-        if (Active.Len >= SubstringLen) {
-          // If yes, then consume the characters we've seen and move to the next
-          // node.
-          Active.Idx += SubstringLen;
-          Active.Len -= SubstringLen;
-          Active.Node = NextNode;
-          continue;
-        }
-
-        // Otherwise, the suffix we're trying to insert must be contained in the
-        // next node we want to move to.
-        unsigned LastChar = Str[EndIdx];
-
-        // Is the string we're trying to insert a substring of the next node?
-        if (Str[NextNode->StartIdx + Active.Len] == LastChar) {
-          // If yes, then we're done for this step. Remember our insertion point
-          // and move to the next end index. At this point, we have an implicit
-          // suffix tree.
-          if (NeedsLink && !Active.Node->isRoot()) {
-            NeedsLink->Link = Active.Node;
-            NeedsLink = nullptr;
-          }
-
-          Active.Len++;
-          break;
-        }
+  /// Record a repeated substring of length \p Length whose occurrences that
+  /// are not part of a longer repeat start at \p Starts.
+  void addRepeatedSubstring(unsigned Length, MutableArrayRef<unsigned> Starts) {
+    if (Starts.size() < 2)
+      return;
+    llvm::sort(Starts.begin(), Starts.end());
+    unsigned Begin = StartIndices.size();
+    StartIndices.insert(StartIndices.end(), Starts.begin(), Starts.end());
+    RepeatedSubstrings.push_back({Length, Begin, (unsigned)StartIndices.size()});
+  }
 
-        // The string we're trying to insert isn't a substring of the next node,
-        // but matches up to a point. Split the node.
-        //
-        // For example, say we ended our search at a node n and we're trying to
-        // insert ABD. Then we'll create a new node s for AB, reduce n to just
-        // representing C, and insert a new leaf node l to represent d. This
-        // allows us to ensure that if n was a leaf, it remains a leaf.
-        //
-        //   | ABC  ---split--->  | AB
-        //   n                    s
-        //                     C / \ D
-        //                      n   l
-
-        // The node s from the diagram
-        SuffixTreeNode *SplitNode =
-            insertInternalNode(Active.Node, NextNode->StartIdx,
-                               NextNode->StartIdx + Active.Len - 1, FirstChar);
-
-        // Insert the new node representing the new substring into the tree as
-        // a child of the split node. This is the node l from the diagram.
-        insertLeaf(*SplitNode, EndIdx, LastChar);
-
-        // Make the old node a child of the split node and update its start
-        // index. This is the node n from the diagram.
-        NextNode->StartIdx += Active.Len;
-        NextNode->Parent = SplitNode;
-        SplitNode->Children[Str[NextNode->StartIdx]] = NextNode;
-
-        // SplitNode is an internal node, update the suffix link.
-        if (NeedsLink)
-          NeedsLink->Link = SplitNode;
-
-        NeedsLink = SplitNode;
+  /// Find the repeated substrings of \p Str given its suffix array \p SA and
+  /// LCP array \p LCP.
+  ///
+  /// This visits the suffix tree nodes bottom-up. A node is a maximal range
+  /// of suffixes whose common prefixes are at least as long as the node's
+  /// substring; the scan keeps a stack of the nodes containing the current
+  /// suffix. A suffix is a leaf child of the deeper node among the ones
+  /// containing it and its predecessor or its successor.
+  void findRepeatedSubstrings(ArrayRef<unsigned> SA, ArrayRef<unsigned> LCP) {
+    struct Node {
+      /// The length of the node's substring.
+      unsigned Length;
+
+      /// The position in \p Leaves of the node's first leaf child.
+      unsigned LeavesBegin;
+    };
+
+    unsigned N = Str.size();
+    SmallVector<Node, 32> Stack;
+    std::vector<unsigned> Leaves;
+    Stack.push_back({0, 0});
+    for (unsigned I = 1; I <= N; ++I) {
+      unsigned Len = I < N ? LCP[I] : 0;
+
+      // The suffix at SA[I - 1] shares more with its successor: it branches
+      // off a new, deeper node.
+      if (Len > Stack.back().Length) {
+        Stack.push_back({Len, (unsigned)Leaves.size()});
+        Leaves.push_back(SA[I - 1]);
+        continue;
       }
 
-      // We've added something new to the tree, so there's one less suffix to
-      // add.
-      SuffixesToAdd--;
-
-      if (Active.Node->isRoot()) {
-        if (Active.Len > 0) {
-          Active.Len--;
-          Active.Idx = EndIdx - SuffixesToAdd + 1;
-        }
-      } else {
-        // Start the next phase at the next smallest suffix.
-        Active.Node = Active.Node->Link;
+      // Otherwise it branches off the deepest node, and the nodes deeper
+      // than the common prefix with the successor end here.
+      Leaves.push_back(SA[I - 1]);
+      while (Len < Stack.back().Length) {
+        Node Top = Stack.pop_back_val();
+        addRepeatedSubstring(
+            Top.Length, MutableArrayRef<unsigned>(Leaves).slice(Top.LeavesBegin));
+        Leaves.resize(Top.LeavesBegin);
+        if (Len > Stack.back().Length)
+          Stack.push_back({Len, (unsigned)Leaves.size()});
       }
     }
 
-    return SuffixesToAdd;
+    // Visit the substrings in the order of their first occurrence.
+    llvm::sort(RepeatedSubstrings.begin(), RepeatedSubstrings.end(),
+               [this](const RepeatedSubstring &L, const RepeatedSubstring &R) {
+                 return StartIndices[L.Begin] < StartIndices[R.Begin];
+               });
   }
 
 public:
-  /// Construct a suffix tree from a sequence of unsigned integers.
+  /// Find the repeated substrings of a sequence of unsigned integers.
   ///
-  /// \param Str The string to construct the suffix tree for.
-  SuffixTree(const std::vector<unsigned> &Str) : Str(Str) {
-    Root = insertInternalNode(nullptr, EmptyIdx, EmptyIdx, 0);
-    Root->IsInTree = true;
-    Active.Node = Root;
-    LeafVector = std::vector<SuffixTreeNode *>(Str.size());
-
-    // Keep track of the number of suffixes we have to add of the current
-    // prefix.
-    unsigned SuffixesToAdd = 0;
-    Active.Node = Root;
-
-    // Construct the suffix tree iteratively on each prefix of the string.
-    // PfxEndIdx is the end index of the current prefix.
-    // End is one past the last element in the string.
-    for (unsigned PfxEndIdx = 0, End = Str.size(); PfxEndIdx < End;
-         PfxEndIdx++) {
-      SuffixesToAdd++;
-      LeafEndIdx = PfxEndIdx; // Extend each of the leaves.
-      SuffixesToAdd = extend(PfxEndIdx, SuffixesToAdd);
-    }
-
-    // Set the suffix indices of each leaf.
-    assert(Root && "Root node can't be nullptr!");
-    setSuffixIndices(*Root, 0);
+  /// \param Str The string to search. Each of its suffixes must be unique.
+  SuffixArray(const std::vector<unsigned> &Str) : Str(Str) {
+    std::vector<unsigned> SA, Rank, LCP;
+    sortSuffixes(SA, Rank);
+    computeLCP(SA, Rank, LCP);
+    Rank = std::vector<unsigned>();
+    findRepeatedSubstrings(SA, LCP);
   }
 };
 
@@ -616,7 +406,7 @@ struct InstructionMapper {
   ///
   /// Two instructions are assigned the same integer if they are identical.
   /// If an instruction is deemed unsafe to outline, then it will be assigned an
-  /// unique integer. The resulting mapping is placed into a suffix tree and
+  /// unique integer. The resulting mapping is placed into a suffix array and
   /// queried for candidates.
   ///
   /// \param MBB The \p MachineBasicBlock to be translated into integers.
@@ -673,8 +463,8 @@ struct InstructionMapper {
 /// instructions and replaces them with calls to functions.
 ///
 /// Each instruction is mapped to an unsigned integer and placed in a string.
-/// The resulting mapping is then placed in a \p SuffixTree. The \p SuffixTree
-/// is then repeatedly queried for repeated sequences of instructions. Each
+/// The resulting mapping is then placed in a \p SuffixArray, which is
+/// queried for repeated sequences of instructions. Each
 /// non-overlapping repeated sequence is then placed in its own
 /// \p MachineFunction and each instance is then replaced with a call to that
 /// function.
@@ -720,13 +510,18 @@ struct MachineOutliner : public ModulePass {
   /// Find all repeated substrings that satisfy the outlining cost model.
   ///
   /// If a substring appears at least twice, then it must be represented by
-  /// an internal node which appears in at least two suffixes. Each suffix
-  /// is represented by a leaf node. To do this, we visit each internal node
-  /// in the tree, using the leaf children of each internal node. If an
-  /// internal node represents a beneficial substring, then we use each of
-  /// its leaf children to find the locations of its substring.
+  /// an internal node of the suffix tree which appears in at least two
+  /// suffixes. The suffix array lists the leaf children of each such node,
+  /// which are the locations of its substring that do not continue into a
+  /// longer repeat. If a substring is beneficial, then we use those locations
+  /// as its candidates.
   ///
-  /// \param ST A suffix tree to query.
+  /// The candidates of each substring and the target's cost model for them
+  /// are computed on several threads, a batch of substrings at a time. The
+  /// results are then added to \p FunctionList in the order of the
+  /// substrings, so the outcome does not depend on the number of threads.
+  ///
+  /// \param SA A suffix array to query.
   /// \param Mapper Contains outlining mapping information.
   /// \param[out] CandidateList Filled with candidates representing each
   /// beneficial substring.
@@ -735,7 +530,7 @@ struct MachineOutliner : public ModulePass {
   ///
   /// \returns The length of the longest candidate found.
   unsigned
-  findCandidates(SuffixTree &ST,
+  findCandidates(SuffixArray &SA,
                  InstructionMapper &Mapper,
                  std::vector<std::shared_ptr<Candidate>> &CandidateList,
                  std::vector<OutlinedFunction> &FunctionList);
@@ -766,25 +561,25 @@ struct MachineOutliner : public ModulePass {
   /// \param[out] CandidateList Filled with outlining candidates for the module.
   /// \param[out] FunctionList Filled with functions corresponding to each type
   /// of \p Candidate.
-  /// \param ST The suffix tree for the module.
+  /// \param SA The suffix array for the module.
   ///
   /// \returns The length of the longest candidate found. 0 if there are none.
   unsigned
   buildCandidateList(std::vector<std::shared_ptr<Candidate>> &CandidateList,
                      std::vector<OutlinedFunction> &FunctionList,
-                     SuffixTree &ST, InstructionMapper &Mapper);
+                     SuffixArray &SA, InstructionMapper &Mapper);
 
   /// Helper function for pruneOverlaps.
   /// Removes \p C from the candidate list, and updates its \p OutlinedFunction.
   void prune(Candidate &C, std::vector<OutlinedFunction> &FunctionList);
 
-  /// Remove any overlapping candidates that weren't handled by the
-  /// suffix tree's pruning method.
+  /// Remove any overlapping candidates that weren't removed when finding
+  /// candidates.
   ///
-  /// Pruning from the suffix tree doesn't necessarily remove all overlaps.
-  /// If a short candidate is chosen for outlining, then a longer candidate
-  /// which has that short candidate as a suffix is chosen, the tree's pruning
-  /// method will not find it. Thus, we need to prune before outlining as well.
+  /// Finding candidates only removes overlaps between the occurrences of the
+  /// same sequence. If a short candidate is chosen for outlining, then a
+  /// longer candidate which has that short candidate as a suffix is chosen,
+  /// findCandidates will not notice. Thus, we need to prune before outlining as well.
   ///
   /// \param[in,out] CandidateList A list of outlining candidates.
   /// \param[in,out] FunctionList A list of functions to be outlined.
@@ -794,8 +589,8 @@ struct MachineOutliner : public ModulePass {
                      std::vector<OutlinedFunction> &FunctionList,
                      InstructionMapper &Mapper, unsigned MaxCandidateLen);
 
-  /// Construct a suffix tree on the instructions in \p M and outline repeated
-  /// strings from that tree.
+  /// Construct a suffix array on the instructions in \p M and outline
+  /// repeated strings found in that array.
   bool runOnModule(Module &M) override;
 
   /// Return a DISubprogram for OF if one exists, and null otherwise. Helper
@@ -885,47 +680,44 @@ void MachineOutliner::emitOutlinedFunctionRemark(OutlinedFunction &OF) {
 }
 
 unsigned MachineOutliner::findCandidates(
-    SuffixTree &ST, InstructionMapper &Mapper,
+    SuffixArray &SA, InstructionMapper &Mapper,
     std::vector<std::shared_ptr<Candidate>> &CandidateList,
     std::vector<OutlinedFunction> &FunctionList) {
   CandidateList.clear();
   FunctionList.clear();
   unsigned MaxLen = 0;
 
-  // FIXME: Visit internal nodes instead of leaves.
-  for (SuffixTreeNode *Leaf : ST.LeafVector) {
-    assert(Leaf && "Leaves in LeafVector cannot be null!");
-    if (!Leaf->IsInTree)
-      continue;
-
-    assert(Leaf->Parent && "All leaves must have parents!");
-    SuffixTreeNode &Parent = *(Leaf->Parent);
-
-    // If it doesn't appear enough, or we already outlined from it, skip it.
-    if (Parent.OccurrenceCount < 2 || Parent.isRoot() || !Parent.IsInTree)
-      continue;
-
-    // Figure out if this candidate is beneficial.
-    unsigned StringLen = Leaf->ConcatLen - (unsigned)Leaf->size();
-
-    // Too short to be beneficial; skip it.
-    // FIXME: This isn't necessarily true for, say, X86. If we factor in
-    // instruction lengths we need more information than this.
-    if (StringLen < 2)
-      continue;
-
-    // If this is a beneficial class of candidate, then every one is stored in
-    // this vector.
-    std::vector<Candidate> CandidatesForRepeatedSeq;
-
-    // Figure out the call overhead for each instance of the sequence.
-    for (auto &ChildPair : Parent.Children) {
-      SuffixTreeNode *M = ChildPair.second;
-
-      if (M && M->IsInTree && M->isLeaf()) {
-        // Never visit this leaf again.
-        M->IsInTree = false;
-        unsigned StartIdx = M->SuffixIdx;
+  // The number of repeated substrings whose candidates are kept in memory at
+  // once.
+  const size_t BatchSize = 4096;
+
+  ArrayRef<SuffixArray::RepeatedSubstring> Repeats = SA.RepeatedSubstrings;
+  for (size_t BatchBegin = 0, E = Repeats.size(); BatchBegin < E;
+       BatchBegin += BatchSize) {
+    ArrayRef<SuffixArray::RepeatedSubstring> Batch =
+        Repeats.slice(BatchBegin, std::min(BatchSize, E - BatchBegin));
+
+    // If a class of candidate is beneficial, then every one is stored in
+    // these vectors.
+    std::vector<std::vector<Candidate>> CandidatesForRepeatedSeqs(
+        Batch.size());
+    std::vector<OutlinedFunction> OutlinedFunctions(Batch.size());
+
+    // Find the candidates of each substring and ask the target what outlining
+    // them would cost. Each substring only touches its own candidates.
+    parallel::for_each_n(parallel::par, size_t(0), Batch.size(), [&](size_t I) {
+      const SuffixArray::RepeatedSubstring &RS = Batch[I];
+      unsigned StringLen = RS.Length;
+
+      // Too short to be beneficial; skip it.
+      // FIXME: This isn't necessarily true for, say, X86. If we factor in
+      // instruction lengths we need more information than this.
+      if (StringLen < 2)
+        return;
+
+      std::vector<Candidate> &CandidatesForRepeatedSeq =
+          CandidatesForRepeatedSeqs[I];
+      for (unsigned StartIdx : SA.getStartIndices(RS)) {
         unsigned EndIdx = StartIdx + StringLen - 1;
 
         // Trick: Discard some candidates that would be incompatible with the
@@ -944,72 +736,62 @@ unsigned MachineOutliner::findCandidates(
         // at most 3 can be outlined. If only outlining 3 of these is going to
         // be unbeneficial, then we ought to not bother.
         //
-        // Note that two things DON'T overlap when they look like this:
-        // start1...end1 .... start2...end2
-        // That is, one must either
-        // * End before the other starts
-        // * Start after the other ends
-        if (std::all_of(CandidatesForRepeatedSeq.begin(),
-                        CandidatesForRepeatedSeq.end(),
-                        [&StartIdx, &EndIdx](const Candidate &C) {
-                          return (EndIdx < C.getStartIdx() ||
-                                  StartIdx > C.getEndIdx());
-                        })) {
-          // It doesn't overlap with anything, so we can outline it.
-          // Each sequence is over [StartIt, EndIt].
-          // Save the candidate and its location.
-
-          MachineBasicBlock::iterator StartIt = Mapper.InstrList[StartIdx];
-          MachineBasicBlock::iterator EndIt = Mapper.InstrList[EndIdx];
-
-          CandidatesForRepeatedSeq.emplace_back(StartIdx, StringLen, StartIt,
-                                                EndIt, StartIt->getParent(),
-                                                FunctionList.size());
-        }
+        // The start indices are increasing, so it's enough to check that this
+        // one starts after the last candidate we kept ends.
+        if (!CandidatesForRepeatedSeq.empty() &&
+            StartIdx <= CandidatesForRepeatedSeq.back().getEndIdx())
+          continue;
+
+        // It doesn't overlap with anything, so we can outline it.
+        // Each sequence is over [StartIt, EndIt].
+        // Save the candidate and its location. Its function index is set once
+        // we know whether the function is beneficial.
+        MachineBasicBlock::iterator StartIt = Mapper.InstrList[StartIdx];
+        MachineBasicBlock::iterator EndIt = Mapper.InstrList[EndIdx];
+        CandidatesForRepeatedSeq.emplace_back(StartIdx, StringLen, StartIt,
+                                              EndIt, StartIt->getParent(), 0);
       }
-    }
 
-    // We've found something we might want to outline.
-    // Create an OutlinedFunction to store it and check if it'd be beneficial
-    // to outline.
-    if (CandidatesForRepeatedSeq.empty())
-      continue;
+      // Arbitrarily choose a TII from the first candidate.
+      // FIXME: Should getOutliningCandidateInfo move to TargetMachine?
+      const TargetInstrInfo *TII =
+          CandidatesForRepeatedSeq[0].getMF()->getSubtarget().getInstrInfo();
 
-    // Arbitrarily choose a TII from the first candidate.
-    // FIXME: Should getOutliningCandidateInfo move to TargetMachine?
-    const TargetInstrInfo *TII =
-        CandidatesForRepeatedSeq[0].getMF()->getSubtarget().getInstrInfo();
+      OutlinedFunctions[I] =
+          TII->getOutliningCandidateInfo(CandidatesForRepeatedSeq);
+    });
 
-    OutlinedFunction OF =
-        TII->getOutliningCandidateInfo(CandidatesForRepeatedSeq);
+    for (size_t I = 0, BE = Batch.size(); I != BE; ++I) {
+      OutlinedFunction &OF = OutlinedFunctions[I];
 
-    // If we deleted every candidate, then there's nothing to outline.
-    if (OF.Candidates.empty())
-      continue;
+      // If we deleted every candidate, then there's nothing to outline.
+      if (OF.Candidates.empty())
+        continue;
 
-    std::vector<unsigned> Seq;
-    for (unsigned i = Leaf->SuffixIdx; i < Leaf->SuffixIdx + StringLen; i++)
-      Seq.push_back(ST.Str[i]);
-    OF.Sequence = Seq;
-    OF.Name = FunctionList.size();
+      unsigned StringLen = Batch[I].Length;
+      unsigned StartIdx = OF.Candidates[0]->getStartIdx();
+      OF.Sequence.assign(SA.Str.begin() + StartIdx,
+                         SA.Str.begin() + StartIdx + StringLen);
+      OF.Name = FunctionList.size();
 
-    // Is it better to outline this candidate than not?
-    if (OF.getBenefit() < 1) {
-      emitNotOutliningCheaperRemark(StringLen, CandidatesForRepeatedSeq, OF);
-      continue;
-    }
-
-    if (StringLen > MaxLen)
-      MaxLen = StringLen;
+      // Is it better to outline this candidate than not?
+      if (OF.getBenefit() < 1) {
+        emitNotOutliningCheaperRemark(StringLen, CandidatesForRepeatedSeqs[I],
+                                      OF);
+        continue;
+      }
 
-    // The function is beneficial. Save its candidates to the candidate list
-    // for pruning.
-    for (std::shared_ptr<Candidate> &C : OF.Candidates)
-      CandidateList.push_back(C);
-    FunctionList.push_back(OF);
+      if (StringLen > MaxLen)
+        MaxLen = StringLen;
 
-    // Move to the next function.
-    Parent.IsInTree = false;
+      // The function is beneficial. Save its candidates to the candidate list
+      // for pruning.
+      for (std::shared_ptr<Candidate> &C : OF.Candidates) {
+        C->FunctionIdx = FunctionList.size();
+        CandidateList.push_back(C);
+      }
+      FunctionList.push_back(std::move(OF));
+    }
   }
 
   return MaxLen;
@@ -1127,14 +909,14 @@ void MachineOutliner::pruneOverlaps(
 
 unsigned MachineOutliner::buildCandidateList(
     std::vector<std::shared_ptr<Candidate>> &CandidateList,
-    std::vector<OutlinedFunction> &FunctionList, SuffixTree &ST,
+    std::vector<OutlinedFunction> &FunctionList, SuffixArray &SA,
     InstructionMapper &Mapper) {
 
   std::vector<unsigned> CandidateSequence; // Current outlining candidate.
   unsigned MaxCandidateLen = 0;            // Length of the longest candidate.
 
   MaxCandidateLen =
-      findCandidates(ST, Mapper, CandidateList, FunctionList);
+      findCandidates(SA, Mapper, CandidateList, FunctionList);
 
   // Sort the candidates in decending order. This will simplify the outlining
   // process when we have to remove the candidates from the mapping by
@@ -1408,14 +1190,15 @@ bool MachineOutliner::runOnModule(Module &M) {
     }
   }
 
-  // Construct a suffix tree, use it to find candidates, and then outline them.
-  SuffixTree ST(Mapper.UnsignedVec);
+  // Construct a suffix array, use it to find candidates, and then outline
+  // them.
+  SuffixArray SA(Mapper.UnsignedVec);
   std::vector<std::shared_ptr<Candidate>> CandidateList;
   std::vector<OutlinedFunction> FunctionList;
 
   // Find all of the outlining candidates.
   unsigned MaxCandidateLen =
-      buildCandidateList(CandidateList, FunctionList, ST, Mapper);
+      buildCandidateList(CandidateList, FunctionList, SA, Mapper);
 
   // Remove candidates that overlap with other candidates.
   pruneOverlaps(CandidateList, FunctionList, Mapper, MaxCandidateLen);
@@ -85,6 +85,10 @@ using namespace llvm;
 STATISTIC(NumGlobalSplits, "Number of split global live ranges");
 STATISTIC(NumLocalSplits,  "Number of split local live ranges");
 STATISTIC(NumEvicted,      "Number of interferences evicted");
+STATISTIC(NumEvictBudgetHit,
+          "Number of eviction searches stopped by the search budget");
+STATISTIC(NumSplitBudgetHit,
+          "Number of region split searches stopped by the search budget");
 
 static cl::opt<SplitEditor::ComplementSpillMode> SplitSpillMode(
     "split-spill-mode", cl::Hidden,
@@ -137,6 +141,30 @@ CSRFirstTimeCost("regalloc-csr-first-time-cost",
               cl::desc("Cost for first time use of callee-saved register."),
               cl::init(0), cl::Hidden);
 
+static cl::opt<bool> BoundedSearch(
+    "greedy-bounded-search", cl::Hidden,
+    cl::desc("Bound the eviction and region split search done for each live "
+             "range, trading allocation quality for predictable compile time"),
+    cl::init(false));
+
+static cl::opt<unsigned> EvictSearchBudget(
+    "greedy-evict-search-budget", cl::Hidden,
+    cl::desc("With -greedy-bounded-search, the number of registers whose "
+             "interference is examined when trying to evict"),
+    cl::init(8));
+
+static cl::opt<unsigned> SplitSearchBudget(
+    "greedy-split-search-budget", cl::Hidden,
+    cl::desc("With -greedy-bounded-search, the number of registers whose "
+             "split region is grown when trying to split around a region"),
+    cl::init(4));
+
+static cl::opt<unsigned> SpillPlacementBudget(
+    "greedy-spill-placement-budget", cl::Hidden,
+    cl::desc("With -greedy-bounded-search, the number of spill placement "
+             "node updates done for each split candidate"),
+    cl::init(2000));
+
 static cl::opt<bool> ConsiderLocalIntervalCost(
     "condsider-local-interval-cost", cl::Hidden,
     cl::desc("Consider the cost of local intervals created by a split "
@@ -1128,6 +1156,9 @@ unsigned RAGreedy::tryEvict(LiveInterval &VirtReg,
     }
   }
 
+  // Unspillable ranges have no cheaper fallback, so they search everything.
+  unsigned Budget =
+      BoundedSearch && VirtReg.isSpillable() ? EvictSearchBudget : ~0u;
   Order.rewind();
   while (unsigned PhysReg = Order.next(OrderLimit)) {
     if (TRI->getCostPerUse(PhysReg) >= CostPerUseLimit)
@@ -1142,6 +1173,14 @@ unsigned RAGreedy::tryEvict(LiveInterval &VirtReg,
       continue;
     }
 
+    // Settle for the best candidate so far, or let splitting and spilling
+    // handle VirtReg, once the budget is spent.
+    if (!Budget--) {
+      LLVM_DEBUG(dbgs() << "Eviction search budget exhausted.\n");
+      ++NumEvictBudgetHit;
+      break;
+    }
+
     if (!canEvictInterference(VirtReg, PhysReg, false, BestCost))
       continue;
 
@@ -1838,11 +1877,21 @@ unsigned RAGreedy::calculateRegionSplitCost(LiveInterval &VirtReg,
                                             unsigned &NumCands, bool IgnoreCSR,
                                             bool *CanCauseEvictionChain) {
   unsigned BestCand = NoCand;
+  unsigned Budget = BoundedSearch ? SplitSearchBudget : ~0u;
   Order.rewind();
   while (unsigned PhysReg = Order.next()) {
     if (IgnoreCSR && isUnusedCalleeSavedReg(PhysReg))
       continue;
 
+    // Growing the region is the expensive part. When the budget is spent,
+    // go with the best candidate so far; without one, tryRegionSplit falls
+    // back to per-block splitting.
+    if (!Budget) {
+      LLVM_DEBUG(dbgs() << "Region split search budget exhausted.\n");
+      ++NumSplitBudgetHit;
+      break;
+    }
+
     // Discard bad candidates before we run out of interference cache cursors.
     // This will only affect register classes with a lot of registers (>32).
     if (NumCands == IntfCache.getMaxCursors()) {
@@ -1886,6 +1935,7 @@ unsigned RAGreedy::calculateRegionSplitCost(LiveInterval &VirtReg,
       });
       continue;
     }
+    --Budget;
     growRegion(Cand);
 
     SpillPlacer->finish();
@@ -3185,6 +3235,7 @@ bool RAGreedy::runOnMachineFunction(MachineFunction &mf) {
   Loops = &getAnalysis<MachineLoopInfo>();
   Bundles = &getAnalysis<EdgeBundles>();
   SpillPlacer = &getAnalysis<SpillPlacement>();
+  SpillPlacer->setUpdateBudget(BoundedSearch ? SpillPlacementBudget : 0);
   DebugVars = &getAnalysis<LiveDebugVariables>();
   AA = &getAnalysis<AAResultsWrapperPass>().getAAResults();
 
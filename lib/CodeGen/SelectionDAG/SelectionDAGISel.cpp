@@ -111,6 +111,12 @@ STATISTIC(NumDAGIselRetries,"Number of times dag isel has to try another path");
 STATISTIC(NumEntryBlocks, "Number of entry blocks encountered");
 STATISTIC(NumFastIselFailLowerArguments,
           "Number of entry blocks where fast isel failed to lower arguments");
+STATISTIC(NumMatcherNodes, "Number of nodes run through the isel matcher");
+STATISTIC(NumMatcherSteps, "Number of isel matcher table opcodes executed");
+STATISTIC(NumSwitchCasesScanned,
+          "Number of isel matcher switch cases scanned linearly");
+STATISTIC(NumSwitchTableLookups,
+          "Number of isel matcher switches dispatched through a case table");
 
 static cl::opt<int> EnableFastISelAbort(
     "fast-isel-abort", cl::Hidden,
@@ -2881,8 +2887,58 @@ public:
   }
 };
 
+/// Accumulates the matcher statistics for one node locally and publishes them
+/// when the match finishes, to keep atomic updates out of the interpreter loop.
+struct MatcherStepCounter {
+  unsigned Steps = 0;
+  unsigned CasesScanned = 0;
+  unsigned TableLookups = 0;
+
+  ~MatcherStepCounter() {
+    ++NumMatcherNodes;
+    NumMatcherSteps += Steps;
+    NumSwitchCasesScanned += CasesScanned;
+    NumSwitchTableLookups += TableLookups;
+  }
+};
+
 } // end anonymous namespace
 
+/// Number of cases of an OPC_SwitchOpcode or OPC_SwitchType that are scanned
+/// linearly before the rest of the lookup goes through a case table.  Most
+/// switches have only a handful of cases and never get a table.
+static const unsigned MaxLinearSwitchCases = 4;
+
+const std::vector<unsigned> &
+SelectionDAGISel::getSwitchCaseTable(const unsigned char *MatcherTable,
+                                     unsigned SwitchStart) {
+  std::vector<unsigned> &Table = SwitchCaseTables[SwitchStart];
+  if (!Table.empty())
+    return Table;
+
+  bool IsOpcodeSwitch = MatcherTable[SwitchStart] == OPC_SwitchOpcode;
+  assert((IsOpcodeSwitch || MatcherTable[SwitchStart] == OPC_SwitchType) &&
+         "Not a switch");
+  unsigned Idx = SwitchStart + 1;
+  while (true) {
+    unsigned CaseSize = MatcherTable[Idx++];
+    if (CaseSize & 128)
+      CaseSize = GetVBR(CaseSize, MatcherTable, Idx);
+    if (CaseSize == 0) break;
+
+    unsigned Key = MatcherTable[Idx++];
+    if (IsOpcodeSwitch)
+      Key |= (unsigned)MatcherTable[Idx++] << 8;
+    if (Key >= Table.size())
+      Table.resize(Key + 1);
+    // Only the first case for a key is ever executed.
+    if (Table[Key] == 0)
+      Table[Key] = Idx;
+    Idx += CaseSize;
+  }
+  return Table;
+}
+
 void SelectionDAGISel::SelectCodeCommon(SDNode *NodeToMatch,
                                         const unsigned char *MatcherTable,
                                         unsigned TableSize) {
@@ -2936,6 +2992,8 @@ void SelectionDAGISel::SelectCodeCommon(SDNode *NodeToMatch,
 
   assert(!NodeToMatch->isMachineOpcode() && "Node already selected!");
 
+  MatcherStepCounter Counter;
+
   // Set up the node stack with NodeToMatch as the only node on the stack.
   SmallVector<SDValue, 8> NodeStack;
   SDValue N = SDValue(NodeToMatch, 0);
@@ -3011,6 +3069,7 @@ void SelectionDAGISel::SelectCodeCommon(SDNode *NodeToMatch,
     unsigned CurrentOpcodeIndex = MatcherIndex;
 #endif
     BuiltinOpcodes Opcode = (BuiltinOpcodes)MatcherTable[MatcherIndex++];
+    ++Counter.Steps;
     switch (Opcode) {
     case OPC_Scope: {
       // Okay, the semantics of this operation are that we should push a scope
@@ -3194,14 +3253,27 @@ void SelectionDAGISel::SelectCodeCommon(SDNode *NodeToMatch,
 
     case OPC_SwitchOpcode: {
       unsigned CurNodeOpcode = N.getOpcode();
-      unsigned SwitchStart = MatcherIndex-1; (void)SwitchStart;
+      unsigned SwitchStart = MatcherIndex-1;
       unsigned CaseSize;
-      while (true) {
+      for (unsigned NumCases = 0;; ++NumCases) {
+        if (NumCases == MaxLinearSwitchCases) {
+          // This is a large switch, look the opcode up in its case table.  A
+          // nonzero CaseSize tells the code below that a case was found.
+          const std::vector<unsigned> &Cases =
+              getSwitchCaseTable(MatcherTable, SwitchStart);
+          ++Counter.TableLookups;
+          MatcherIndex =
+              CurNodeOpcode < Cases.size() ? Cases[CurNodeOpcode] : 0;
+          CaseSize = MatcherIndex;
+          break;
+        }
+
         // Get the size of this case.
         CaseSize = MatcherTable[MatcherIndex++];
         if (CaseSize & 128)
           CaseSize = GetVBR(CaseSize, MatcherTable, MatcherIndex);
         if (CaseSize == 0) break;
+        ++Counter.CasesScanned;
 
         uint16_t Opc = MatcherTable[MatcherIndex++];
         Opc |= (unsigned short)MatcherTable[MatcherIndex++] << 8;
@@ -3225,14 +3297,32 @@ void SelectionDAGISel::SelectCodeCommon(SDNode *NodeToMatch,
 
     case OPC_SwitchType: {
       MVT CurNodeVT = N.getSimpleValueType();
-      unsigned SwitchStart = MatcherIndex-1; (void)SwitchStart;
+      unsigned SwitchStart = MatcherIndex-1;
       unsigned CaseSize;
-      while (true) {
+      for (unsigned NumCases = 0;; ++NumCases) {
+        if (NumCases == MaxLinearSwitchCases) {
+          // This is a large switch, look the type up in its case table.  An
+          // iPTR case matches too if it comes first and CurNodeVT is the
+          // pointer type.
+          const std::vector<unsigned> &Cases =
+              getSwitchCaseTable(MatcherTable, SwitchStart);
+          ++Counter.TableLookups;
+          unsigned VT = CurNodeVT.SimpleTy;
+          MatcherIndex = VT < Cases.size() ? Cases[VT] : 0;
+          if (MVT::iPTR < Cases.size() && Cases[MVT::iPTR] != 0 &&
+              (MatcherIndex == 0 || Cases[MVT::iPTR] < MatcherIndex) &&
+              TLI->getPointerTy(CurDAG->getDataLayout()) == CurNodeVT)
+            MatcherIndex = Cases[MVT::iPTR];
+          CaseSize = MatcherIndex;
+          break;
+        }
+
         // Get the size of this case.
         CaseSize = MatcherTable[MatcherIndex++];
         if (CaseSize & 128)
           CaseSize = GetVBR(CaseSize, MatcherTable, MatcherIndex);
         if (CaseSize == 0) break;
+        ++Counter.CasesScanned;
 
         MVT CaseVT = (MVT::SimpleValueType)MatcherTable[MatcherIndex++];
         if (CaseVT == MVT::iPTR)
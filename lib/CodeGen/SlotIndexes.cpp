@@ -34,6 +34,8 @@ void SlotIndexes::releaseMemory() {
   mi2iMap.clear();
   MBBRanges.clear();
   idx2MBBMap.clear();
+  idx2MBBStarts.clear();
+  idx2MBBNumbers.clear();
   indexList.clear();
   ileAllocator.Reset();
 }
@@ -96,6 +98,7 @@ bool SlotIndexes::runOnMachineFunction(MachineFunction &fn) {
 
   // Sort the Idx2MBBMap
   llvm::sort(idx2MBBMap.begin(), idx2MBBMap.end(), Idx2MBBCompare());
+  packMBBIndexes();
 
   LLVM_DEBUG(mf->print(dbgs(), this));
 
@@ -157,6 +160,7 @@ void SlotIndexes::renumberIndexes() {
     I->setIndex(index);
     index += SlotIndex::InstrDist;
   }
+  packMBBIndexes();
 }
 
 // Renumber indexes locally after curItr was inserted, but failed to get a new
@@ -168,17 +172,47 @@ void SlotIndexes::renumberIndexes(IndexList::iterator curItr) {
 
   IndexList::iterator startItr = std::prev(curItr);
   unsigned index = startItr->getIndex();
+  unsigned oldIndex;
   do {
+    oldIndex = curItr->getIndex();
     curItr->setIndex(index += Space);
     ++curItr;
     // If the next index is bigger, we have caught up.
   } while (curItr != indexList.end() && curItr->getIndex() <= index);
+  repackMBBIndexes(startItr->getIndex(), oldIndex);
 
   LLVM_DEBUG(dbgs() << "\n*** Renumbered SlotIndexes " << startItr->getIndex()
                     << '-' << index << " ***\n");
   ++NumLocalRenum;
 }
 
+void SlotIndexes::packMBBIndexes() {
+  idx2MBBStarts.clear();
+  idx2MBBNumbers.clear();
+  if (idx2MBBMap.empty())
+    return;
+  for (const IdxMBBPair &P : idx2MBBMap) {
+    idx2MBBStarts.push_back(P.first.getIndex());
+    idx2MBBNumbers.push_back(P.second->getNumber());
+  }
+  idx2MBBStarts.push_back(getMBBEndIdx(idx2MBBMap.back().second).getIndex());
+}
+
+void SlotIndexes::repackMBBIndexes(unsigned From, unsigned To) {
+  // insertMBBInMaps renumbers after adding the new block to idx2MBBMap, and
+  // repacks everything once the map is sorted again.
+  if (idx2MBBStarts.size() != idx2MBBMap.size() + 1)
+    return;
+  // The renumbered entries kept their order, and so did the blocks.
+  auto I = std::upper_bound(idx2MBBStarts.begin(), idx2MBBStarts.end(), From);
+  for (; I != idx2MBBStarts.end() && *I <= To; ++I) {
+    unsigned Pos = I - idx2MBBStarts.begin();
+    *I = Pos == idx2MBBMap.size()
+             ? getMBBEndIdx(idx2MBBMap.back().second).getIndex()
+             : idx2MBBMap[Pos].first.getIndex();
+  }
+}
+
 // Repair indexes after adding and removing instructions.
 void SlotIndexes::repairIndexesInRange(MachineBasicBlock *MBB,
                                        MachineBasicBlock::iterator Begin,
@@ -32,6 +32,7 @@
 #include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/SparseSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/CodeGen/EdgeBundles.h"
 #include "llvm/CodeGen/MachineBasicBlock.h"
 #include "llvm/CodeGen/MachineBlockFrequencyInfo.h"
@@ -49,6 +50,9 @@ using namespace llvm;
 
 #define DEBUG_TYPE "spill-code-placement"
 
+STATISTIC(NumUpdateBudgetHit,
+          "Number of placements stopped by the node update budget");
+
 char SpillPlacement::ID = 0;
 
 char &llvm::SpillPlacementID = SpillPlacement::ID;
@@ -350,6 +354,16 @@ void SpillPlacement::iterate() {
   // The call to ::update will add the nodes that changed into the todolist.
   unsigned Limit = bundles->getNumBundles() * 10;
   while(Limit-- > 0 && !TodoList.empty()) {
+    if (UpdateBudget) {
+      if (!UpdatesLeft) {
+        if (!OverBudget)
+          ++NumUpdateBudgetHit;
+        OverBudget = true;
+        TodoList.clear();
+        break;
+      }
+      --UpdatesLeft;
+    }
     unsigned n = TodoList.pop_back_val();
     if (!update(n))
       continue;
@@ -361,6 +375,8 @@ void SpillPlacement::iterate() {
 void SpillPlacement::prepare(BitVector &RegBundles) {
   RecentPositive.clear();
   TodoList.clear();
+  UpdatesLeft = UpdateBudget;
+  OverBudget = false;
   // Reuse RegBundles as our ActiveNodes vector.
   ActiveNodes = &RegBundles;
   ActiveNodes->clear();
@@ -374,7 +390,7 @@ SpillPlacement::finish() {
   // Write preferences back to ActiveNodes.
   bool Perfect = true;
   for (unsigned n : ActiveNodes->set_bits())
-    if (!nodes[n].preferReg()) {
+    if (OverBudget || !nodes[n].preferReg()) {
       ActiveNodes->reset(n);
       Perfect = false;
     }
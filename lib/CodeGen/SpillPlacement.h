@@ -70,6 +70,16 @@ class SpillPlacement : public MachineFunctionPass {
   /// List of nodes that need to be updated in ::iterate.
   SparseSet<unsigned> TodoList;
 
+  /// Maximum number of node updates per placement computation, or 0 for no
+  /// limit. See setUpdateBudget.
+  unsigned UpdateBudget = 0;
+
+  /// Node updates left before the current computation is abandoned.
+  unsigned UpdatesLeft = 0;
+
+  /// Set when the current computation ran out of its update budget.
+  bool OverBudget = false;
+
 public:
   static char ID; // Pass identification, replacement for typeid.
 
@@ -107,6 +117,14 @@ public:
   ///                   spilled. This vector is retained.
   void prepare(BitVector &RegBundles);
 
+  /// setUpdateBudget - Limit the number of node updates done by iterate()
+  /// between prepare() and finish(). A network stopped before convergence may
+  /// still prefer a register where a constraint forbids it, so when the
+  /// budget runs out the computation is abandoned: iterate() stops updating
+  /// and finish() selects no bundles.
+  /// @param Budget Maximum number of updates, or 0 for no limit.
+  void setUpdateBudget(unsigned Budget) { UpdateBudget = Budget; }
+
   /// addConstraints - Add constraints and biases. This method may be called
   /// more than once to accumulate constraints.
   /// @param LiveBlocks Constraints for blocks that have the variable live in or
@@ -223,13 +223,14 @@ bool SplitAnalysis::calcLiveBlockInfo() {
   UseE = UseSlots.end();
 
   // Loop over basic blocks where CurLI is live.
+  const SlotIndexes &Indexes = *LIS.getSlotIndexes();
   MachineFunction::iterator MFI =
       LIS.getMBBFromIndex(LVI->start)->getIterator();
   while (true) {
     BlockInfo BI;
     BI.MBB = &*MFI;
     SlotIndex Start, Stop;
-    std::tie(Start, Stop) = LIS.getSlotIndexes()->getMBBRange(BI.MBB);
+    std::tie(Start, Stop) = Indexes.getMBBRange(BI.MBB);
 
     // If the block contains no uses, the range must be live through. At one
     // point, RegisterCoalescer could create dangling ranges that ended
@@ -241,6 +242,23 @@ bool SplitAnalysis::calcLiveBlockInfo() {
       // happen.
       if (LVI->end < Stop)
         return false;
+
+      // The following blocks are live through as well up to the next use or
+      // the end of the segment. Long ranges can cross thousands of them, so
+      // take them all at once instead of visiting each block.
+      if (LVI->end > Stop) {
+        SlotIndex Limit = LVI->end.getPrevSlot();
+        if (UseI != UseE && *UseI < Limit)
+          Limit = *UseI;
+        ArrayRef<unsigned> Through = Indexes.getMBBNumbersInRange(Stop, Limit);
+        if (!Through.empty()) {
+          for (unsigned Number : Through)
+            ThroughBlocks.set(Number);
+          NumThroughBlocks += Through.size();
+          std::tie(Start, Stop) = Indexes.getMBBRange(Through.back());
+          MFI = LIS.getMBBFromIndex(Start)->getIterator();
+        }
+      }
     } else {
       // This block has uses. Find the first and last uses in the block.
       BI.FirstInstr = *UseI;
@@ -317,25 +335,30 @@ bool SplitAnalysis::calcLiveBlockInfo() {
 unsigned SplitAnalysis::countLiveBlocks(const LiveInterval *cli) const {
   if (cli->empty())
     return 0;
-  LiveInterval *li = const_cast<LiveInterval*>(cli);
-  LiveInterval::iterator LVI = li->begin();
-  LiveInterval::iterator LVE = li->end();
-  unsigned Count = 0;
+  const SlotIndexes &Indexes = *LIS.getSlotIndexes();
+  SlotIndexes::MBBIndexIterator Begin = Indexes.MBBIndexBegin();
+  // Return the layout position of the block containing Idx.
+  auto getBlockPos = [&](SlotIndex Idx) -> unsigned {
+    SlotIndexes::MBBIndexIterator I = Indexes.findMBBIndex(Idx);
+    if (I == Indexes.MBBIndexEnd() || I->first > Idx)
+      --I;
+    return I - Begin;
+  };
 
-  // Loop over basic blocks where li is live.
-  MachineFunction::const_iterator MFI =
-      LIS.getMBBFromIndex(LVI->start)->getIterator();
-  SlotIndex Stop = LIS.getMBBEndIdx(&*MFI);
-  while (true) {
-    ++Count;
-    LVI = li->advanceTo(LVI, Stop);
-    if (LVI == LVE)
-      return Count;
-    do {
-      ++MFI;
-      Stop = LIS.getMBBEndIdx(&*MFI);
-    } while (Stop <= LVI->start);
+  // Add up the blocks spanned by each segment. Segments are sorted, so only
+  // the first block of a segment can have been counted already.
+  unsigned Count = 0;
+  unsigned Prev = ~0u;
+  for (const LiveRange::Segment &S : *cli) {
+    unsigned First = getBlockPos(S.start);
+    unsigned Last = getBlockPos(S.end.getPrevSlot());
+    if (First == Prev)
+      ++First;
+    if (First <= Last)
+      Count += Last - First + 1;
+    Prev = Last;
   }
+  return Count;
 }
 
 bool SplitAnalysis::isOriginalEndpoint(SlotIndex Idx) const {
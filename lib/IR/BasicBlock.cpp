@@ -20,6 +20,7 @@
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Type.h"
+#include "llvm/IR/ValueArena.h"
 #include <algorithm>
 
 using namespace llvm;
@@ -61,6 +62,20 @@ void BasicBlock::insertInto(Function *NewParent, BasicBlock *InsertBefore) {
     NewParent->getBasicBlockList().push_back(this);
 }
 
+void *BasicBlock::operator new(size_t Size) {
+  ValueArena *Arena = ValueArena::getCurrent();
+  void *Storage = Arena ? Arena->allocate(Size) : ::operator new(Size);
+  static_cast<BasicBlock *>(Storage)->IsArenaAllocated = Arena != nullptr;
+  return Storage;
+}
+
+void BasicBlock::operator delete(void *Ptr) {
+  if (static_cast<BasicBlock *>(Ptr)->IsArenaAllocated)
+    ValueArena::deallocate(Ptr);
+  else
+    ::operator delete(Ptr);
+}
+
 BasicBlock::~BasicBlock() {
   // If the address of the block is taken and it is being deleted (e.g. because
   // it is dead), this means that there is either a dangling constant expr
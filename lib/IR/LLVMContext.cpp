@@ -332,6 +332,14 @@ void LLVMContext::setDiscardValueNames(bool Discard) {
   pImpl->DiscardValueNames = Discard;
 }
 
+bool LLVMContext::shouldArenaAllocateFunctionBodies() const {
+  return pImpl->ArenaAllocateFunctionBodies;
+}
+
+void LLVMContext::setArenaAllocateFunctionBodies(bool Enable) {
+  pImpl->ArenaAllocateFunctionBodies = Enable;
+}
+
 OptPassGate &LLVMContext::getOptPassGate() const {
   return pImpl->getOptPassGate();
 }
@@ -15,12 +15,18 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/OptBisect.h"
 #include "llvm/IR/Type.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ManagedStatic.h"
 #include <cassert>
 #include <utility>
 
 using namespace llvm;
 
+static cl::opt<bool> ArenaAllocateFunctionBodiesDefault(
+    "arena-allocate-function-bodies", cl::Hidden, cl::init(false),
+    cl::desc("Allocate the instructions and basic blocks of materialized "
+             "functions from a recycling arena owned by the LLVMContext"));
+
 LLVMContextImpl::LLVMContextImpl(LLVMContext &C)
   : DiagHandler(llvm::make_unique<DiagnosticHandler>()),
     VoidTy(C, Type::VoidTyID),
@@ -39,7 +45,9 @@ LLVMContextImpl::LLVMContextImpl(LLVMContext &C)
     Int16Ty(C, 16),
     Int32Ty(C, 32),
     Int64Ty(C, 64),
-    Int128Ty(C, 128) {}
+    Int128Ty(C, 128) {
+  ArenaAllocateFunctionBodies = ArenaAllocateFunctionBodiesDefault;
+}
 
 LLVMContextImpl::~LLVMContextImpl() {
   // NOTE: We need to delete the contents of OwnedModules, but Module's dtor
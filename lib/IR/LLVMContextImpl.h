@@ -39,6 +39,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Metadata.h"
 #include "llvm/IR/TrackingMDRef.h"
+#include "llvm/IR/ValueArena.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/YAMLTraits.h"
@@ -1216,6 +1217,11 @@ public:
 
 class LLVMContextImpl {
 public:
+  /// Storage for function bodies allocated inside a ValueArenaScope. This is
+  /// declared first so that it outlives every Value destroyed by the members
+  /// below.
+  ValueArena FunctionBodyArena;
+
   /// OwnedModules - The set of modules instantiated in this context, and which
   /// will be automatically deleted if this context is deleted.
   SmallPtrSet<Module*, 4> OwnedModules;
@@ -1378,6 +1384,10 @@ public:
   /// not.
   bool DiscardValueNames = false;
 
+  /// Flag to indicate if function bodies materialized inside a
+  /// ValueArenaScope are allocated from FunctionBodyArena.
+  bool ArenaAllocateFunctionBodies = false;
+
   LLVMContextImpl(LLVMContext &C);
   ~LLVMContextImpl();
 
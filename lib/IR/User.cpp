@@ -10,10 +10,32 @@
 #include "llvm/IR/User.h"
 #include "llvm/IR/Constant.h"
 #include "llvm/IR/GlobalValue.h"
+#include "llvm/IR/ValueArena.h"
 
 namespace llvm {
 class BasicBlock;
 
+/// Allocate the storage of a User, or of its hung-off operands, from \p Arena
+/// if there is one and from the global heap otherwise.
+static void *allocateUserStorage(size_t Size, ValueArena *Arena) {
+  if (Arena)
+    return Arena->allocate(Size);
+  return ::operator new(Size);
+}
+
+static void freeUserStorage(void *Storage, bool IsArenaAllocated) {
+  if (IsArenaAllocated)
+    ValueArena::deallocate(Storage);
+  else
+    ::operator delete(Storage);
+}
+
+/// Drop the hung-off operand list [Begin, End) and free its storage.
+static void freeHungoffUses(Use *Begin, Use *End, bool IsArenaAllocated) {
+  Use::zap(Begin, End, /* Delete */ false);
+  freeUserStorage(Begin, IsArenaAllocated);
+}
+
 //===----------------------------------------------------------------------===//
 //                                 User Class
 //===----------------------------------------------------------------------===//
@@ -50,7 +72,11 @@ void User::allocHungoffUses(unsigned N, bool IsPhi) {
   size_t size = N * sizeof(Use) + sizeof(Use::UserRef);
   if (IsPhi)
     size += N * sizeof(BasicBlock *);
-  Use *Begin = static_cast<Use*>(::operator new(size));
+  // Keep the operands of an arena-allocated User in the same arena.
+  ValueArena *Arena = nullptr;
+  if (IsArenaAllocated)
+    Arena = ValueArena::getOwner(reinterpret_cast<Use **>(this) - 1);
+  Use *Begin = static_cast<Use *>(allocateUserStorage(size, Arena));
   Use *End = Begin + N;
   (void) new(End) Use::UserRef(const_cast<User*>(this), 1);
   setOperandList(Use::initTags(Begin, End));
@@ -80,7 +106,7 @@ void User::growHungoffUses(unsigned NewNumUses, bool IsPhi) {
         reinterpret_cast<char *>(NewOps + NewNumUses) + sizeof(Use::UserRef);
     std::copy(OldPtr, OldPtr + (OldNumUses * sizeof(BasicBlock *)), NewPtr);
   }
-  Use::zap(OldOps, OldOps + OldNumUses, true);
+  freeHungoffUses(OldOps, OldOps + OldNumUses, IsArenaAllocated);
 }
 
 
@@ -121,14 +147,16 @@ void *User::allocateFixedOperandUser(size_t Size, unsigned Us,
   assert(DescBytesToAllocate % sizeof(void *) == 0 &&
          "We need this to satisfy alignment constraints for Uses");
 
-  uint8_t *Storage = static_cast<uint8_t *>(
-      ::operator new(Size + sizeof(Use) * Us + DescBytesToAllocate));
+  ValueArena *Arena = ValueArena::getCurrent();
+  uint8_t *Storage = static_cast<uint8_t *>(allocateUserStorage(
+      Size + sizeof(Use) * Us + DescBytesToAllocate, Arena));
   Use *Start = reinterpret_cast<Use *>(Storage + DescBytesToAllocate);
   Use *End = Start + Us;
   User *Obj = reinterpret_cast<User*>(End);
   Obj->NumUserOperands = Us;
   Obj->HasHungOffUses = false;
   Obj->HasDescriptor = DescBytes != 0;
+  Obj->IsArenaAllocated = Arena != nullptr;
   Use::initTags(Start, End);
 
   if (DescBytes != 0) {
@@ -149,12 +177,14 @@ void *User::operator new(size_t Size, unsigned Us, unsigned DescBytes) {
 
 void *User::operator new(size_t Size) {
   // Allocate space for a single Use*
-  void *Storage = ::operator new(Size + sizeof(Use *));
+  ValueArena *Arena = ValueArena::getCurrent();
+  void *Storage = allocateUserStorage(Size + sizeof(Use *), Arena);
   Use **HungOffOperandList = static_cast<Use **>(Storage);
   User *Obj = reinterpret_cast<User *>(HungOffOperandList + 1);
   Obj->NumUserOperands = 0;
   Obj->HasHungOffUses = true;
   Obj->HasDescriptor = false;
+  Obj->IsArenaAllocated = Arena != nullptr;
   *HungOffOperandList = nullptr;
   return Obj;
 }
@@ -172,21 +202,22 @@ void User::operator delete(void *Usr) {
 
     Use **HungOffOperandList = static_cast<Use **>(Usr) - 1;
     // drop the hung off uses.
-    Use::zap(*HungOffOperandList, *HungOffOperandList + Obj->NumUserOperands,
-             /* Delete */ true);
-    ::operator delete(HungOffOperandList);
+    if (Use *Operands = *HungOffOperandList)
+      freeHungoffUses(Operands, Operands + Obj->NumUserOperands,
+                      Obj->IsArenaAllocated);
+    freeUserStorage(HungOffOperandList, Obj->IsArenaAllocated);
   } else if (Obj->HasDescriptor) {
     Use *UseBegin = static_cast<Use *>(Usr) - Obj->NumUserOperands;
     Use::zap(UseBegin, UseBegin + Obj->NumUserOperands, /* Delete */ false);
 
     auto *DI = reinterpret_cast<DescriptorInfo *>(UseBegin) - 1;
     uint8_t *Storage = reinterpret_cast<uint8_t *>(DI) - DI->SizeInBytes;
-    ::operator delete(Storage);
+    freeUserStorage(Storage, Obj->IsArenaAllocated);
   } else {
     Use *Storage = static_cast<Use *>(Usr) - Obj->NumUserOperands;
     Use::zap(Storage, Storage + Obj->NumUserOperands,
              /* Delete */ false);
-    ::operator delete(Storage);
+    freeUserStorage(Storage, Obj->IsArenaAllocated);
   }
 }
 
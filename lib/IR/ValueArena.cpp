@@ -0,0 +1,76 @@
+//===- ValueArena.cpp - Recycling arena for IR values ---------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the ValueArena and ValueArenaScope classes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/ValueArena.h"
+#include "LLVMContextImpl.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/MathExtras.h"
+#include <cassert>
+
+using namespace llvm;
+
+/// The arena that User and BasicBlock allocations on this thread go to.
+static LLVM_THREAD_LOCAL ValueArena *CurrentArena = nullptr;
+
+void *ValueArena::allocate(size_t Size) {
+  Size = alignTo(Size + sizeof(BlockHeader), SizeClassGranularity);
+  unsigned SizeClass = Size / SizeClassGranularity - 1;
+
+  BlockHeader *Header = nullptr;
+  if (Size > MaxSlabBlockSize) {
+    Header = static_cast<BlockHeader *>(::operator new(Size));
+  } else if (FreeLists[SizeClass]) {
+    FreeBlock *Block = FreeLists[SizeClass];
+    FreeLists[SizeClass] = Block->Next;
+    Header = reinterpret_cast<BlockHeader *>(Block);
+    ++NumRecycled;
+  } else {
+    Header = static_cast<BlockHeader *>(
+        Allocator.Allocate(Size, alignof(BlockHeader)));
+  }
+
+  Header->Owner = this;
+  Header->Size = Size;
+  BytesInUse += Size;
+  return Header + 1;
+}
+
+void ValueArena::deallocate(void *Ptr) {
+  BlockHeader *Header = getHeader(Ptr);
+  ValueArena *Arena = Header->Owner;
+  size_t Size = Header->Size;
+  assert(Arena->BytesInUse >= Size && "Block freed twice?");
+  Arena->BytesInUse -= Size;
+
+  if (Size > MaxSlabBlockSize) {
+    ::operator delete(Header);
+    return;
+  }
+
+  unsigned SizeClass = Size / SizeClassGranularity - 1;
+
+  FreeBlock *Block = reinterpret_cast<FreeBlock *>(Header);
+  Block->Next = Arena->FreeLists[SizeClass];
+  Arena->FreeLists[SizeClass] = Block;
+}
+
+ValueArena *ValueArena::getCurrent() { return CurrentArena; }
+
+ValueArenaScope::ValueArenaScope(LLVMContext &Context)
+    : SavedArena(CurrentArena) {
+  LLVMContextImpl *Impl = Context.pImpl;
+  CurrentArena =
+      Impl->ArenaAllocateFunctionBodies ? &Impl->FunctionBodyArena : nullptr;
+}
+
+ValueArenaScope::~ValueArenaScope() { CurrentArena = SavedArena; }
@@ -38,6 +38,7 @@
 #include "llvm/MC/StringTableBuilder.h"
 #include "llvm/Support/Allocator.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Compression.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/Error.h"
@@ -48,8 +49,10 @@
 #include "llvm/Support/SMLoc.h"
 #include "llvm/Support/StringSaver.h"
 #include "llvm/Support/SwapByteOrder.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -64,6 +67,11 @@ using namespace llvm;
 #undef  DEBUG_TYPE
 #define DEBUG_TYPE "reloc-info"
 
+static cl::opt<unsigned> WriterThreads(
+    "elf-writer-threads", cl::Hidden, cl::init(1),
+    cl::desc("Number of threads used to encode ELF section contents and "
+             "relocations. The output does not depend on this value"));
+
 namespace {
 
 using SectionIndexMapTy = DenseMap<const MCSectionELF *, uint32_t>;
@@ -151,6 +159,16 @@ struct ELFWriter {
   std::vector<const MCSectionELF *> SectionTable;
   unsigned addToSectionTable(const MCSectionELF *Sec);
 
+  // Contents of sections that were encoded ahead of time by encodeSections,
+  // and the buffers holding them.
+  DenseMap<const MCSectionELF *, StringRef> PreEncoded;
+  std::vector<std::vector<SmallVector<char, 0>>> PreEncodedBuffers;
+
+  void encodeSections(
+      ArrayRef<const MCSectionELF *> Sections,
+      function_ref<void(const MCSectionELF &, raw_ostream &)> Encode);
+  bool writePreEncoded(const MCSectionELF &Sec);
+
   // TargetObjectWriter wrappers.
   bool is64Bit() const;
   bool hasRelocationAddend() const;
@@ -219,7 +237,8 @@ public:
                         uint32_t Link, uint32_t Info, uint64_t Alignment,
                         uint64_t EntrySize);
 
-  void writeRelocations(const MCAssembler &Asm, const MCSectionELF &Sec);
+  void writeRelocations(const MCAssembler &Asm, const MCSectionELF &Sec,
+                        raw_ostream &OS);
 
   uint64_t writeObject(MCAssembler &Asm, const MCAsmLayout &Layout);
   void writeSection(const SectionIndexMapTy &SectionIndexMap,
@@ -346,6 +365,54 @@ unsigned ELFWriter::addToSectionTable(const MCSectionELF *Sec) {
   return SectionTable.size();
 }
 
+/// Run \p Encode on each of \p Sections on WriterThreads threads. The threads
+/// take sections from a shared counter and encode them into their own buffers;
+/// writePreEncoded later copies the contents of a section out in file order.
+void ELFWriter::encodeSections(
+    ArrayRef<const MCSectionELF *> Sections,
+    function_ref<void(const MCSectionELF &, raw_ostream &)> Encode) {
+  if (Sections.empty())
+    return;
+
+  struct EncodedSection {
+    unsigned Thread;
+    size_t Begin, End;
+  };
+  unsigned NumThreads = std::min<size_t>(WriterThreads, Sections.size());
+  std::vector<EncodedSection> Encoded(Sections.size());
+  std::vector<SmallVector<char, 0>> Buffers(NumThreads);
+  std::atomic<size_t> NextSection(0);
+
+  ThreadPool Pool(NumThreads);
+  for (unsigned Thread = 0; Thread != NumThreads; ++Thread)
+    Pool.async([&, Thread] {
+      SmallVector<char, 0> &Buffer = Buffers[Thread];
+      raw_svector_ostream OS(Buffer);
+      for (size_t I = NextSection++; I < Sections.size(); I = NextSection++) {
+        size_t Begin = Buffer.size();
+        Encode(*Sections[I], OS);
+        Encoded[I] = {Thread, Begin, Buffer.size()};
+      }
+    });
+  Pool.wait();
+
+  for (size_t I = 0, E = Sections.size(); I != E; ++I) {
+    const EncodedSection &Section = Encoded[I];
+    PreEncoded[Sections[I]] =
+        StringRef(Buffers[Section.Thread].data() + Section.Begin,
+                  Section.End - Section.Begin);
+  }
+  PreEncodedBuffers.push_back(std::move(Buffers));
+}
+
+bool ELFWriter::writePreEncoded(const MCSectionELF &Sec) {
+  auto It = PreEncoded.find(&Sec);
+  if (It == PreEncoded.end())
+    return false;
+  W.OS << It->second;
+  return true;
+}
+
 void SymbolTableWriter::createSymtabShndx() {
   if (!ShndxIndexes.empty())
     return;
@@ -824,6 +891,17 @@ bool ELFWriter::maybeWriteCompression(
   return true;
 }
 
+static bool shouldCompressSection(const MCAssembler &Asm,
+                                  const MCSectionELF &Section) {
+  // Compressing debug_frame requires handling alignment fragments which is
+  // more work (possibly generalizing MCAssembler.cpp:writeFragment to allow
+  // for writing to arbitrary buffers) for little benefit.
+  StringRef SectionName = Section.getSectionName();
+  return Asm.getContext().getAsmInfo()->compressDebugSections() !=
+             DebugCompressionType::None &&
+         SectionName.startswith(".debug_") && SectionName != ".debug_frame";
+}
+
 void ELFWriter::writeSectionData(const MCAssembler &Asm, MCSection &Sec,
                                  const MCAsmLayout &Layout) {
   MCSectionELF &Section = static_cast<MCSectionELF &>(Sec);
@@ -832,13 +910,9 @@ void ELFWriter::writeSectionData(const MCAssembler &Asm, MCSection &Sec,
   auto &MC = Asm.getContext();
   const auto &MAI = MC.getAsmInfo();
 
-  // Compressing debug_frame requires handling alignment fragments which is
-  // more work (possibly generalizing MCAssembler.cpp:writeFragment to allow
-  // for writing to arbitrary buffers) for little benefit.
-  bool CompressionEnabled =
-      MAI->compressDebugSections() != DebugCompressionType::None;
-  if (!CompressionEnabled || !SectionName.startswith(".debug_") ||
-      SectionName == ".debug_frame") {
+  if (writePreEncoded(Section))
+    return;
+  if (!shouldCompressSection(Asm, Section)) {
     Asm.writeSectionData(W.OS, &Section, Layout);
     return;
   }
@@ -893,8 +967,13 @@ void ELFWriter::WriteSecHdrEntry(uint32_t Name, uint32_t Type, uint64_t Flags,
 }
 
 void ELFWriter::writeRelocations(const MCAssembler &Asm,
-                                       const MCSectionELF &Sec) {
-  std::vector<ELFRelocationEntry> &Relocs = OWriter.Relocations[&Sec];
+                                 const MCSectionELF &Sec, raw_ostream &OS) {
+  // This may run on several threads at once, so look the relocations up
+  // rather than using operator[].
+  assert(OWriter.Relocations.count(&Sec) && "No relocations for section");
+  std::vector<ELFRelocationEntry> &Relocs =
+      OWriter.Relocations.find(&Sec)->second;
+  support::endian::Writer RW(OS, W.Endian);
 
   // We record relocations by pushing to the end of a vector. Reverse the vector
   // to get the relocations in the order they were created.
@@ -910,47 +989,47 @@ void ELFWriter::writeRelocations(const MCAssembler &Asm,
     unsigned Index = Entry.Symbol ? Entry.Symbol->getIndex() : 0;
 
     if (is64Bit()) {
-      write(Entry.Offset);
+      RW.write(Entry.Offset);
       if (OWriter.TargetObjectWriter->getEMachine() == ELF::EM_MIPS) {
-        write(uint32_t(Index));
+        RW.write(uint32_t(Index));
 
-        write(OWriter.TargetObjectWriter->getRSsym(Entry.Type));
-        write(OWriter.TargetObjectWriter->getRType3(Entry.Type));
-        write(OWriter.TargetObjectWriter->getRType2(Entry.Type));
-        write(OWriter.TargetObjectWriter->getRType(Entry.Type));
+        RW.write(OWriter.TargetObjectWriter->getRSsym(Entry.Type));
+        RW.write(OWriter.TargetObjectWriter->getRType3(Entry.Type));
+        RW.write(OWriter.TargetObjectWriter->getRType2(Entry.Type));
+        RW.write(OWriter.TargetObjectWriter->getRType(Entry.Type));
       } else {
         struct ELF::Elf64_Rela ERE64;
         ERE64.setSymbolAndType(Index, Entry.Type);
-        write(ERE64.r_info);
+        RW.write(ERE64.r_info);
       }
       if (hasRelocationAddend())
-        write(Entry.Addend);
+        RW.write(Entry.Addend);
     } else {
-      write(uint32_t(Entry.Offset));
+      RW.write(uint32_t(Entry.Offset));
 
       struct ELF::Elf32_Rela ERE32;
       ERE32.setSymbolAndType(Index, Entry.Type);
-      write(ERE32.r_info);
+      RW.write(ERE32.r_info);
 
       if (hasRelocationAddend())
-        write(uint32_t(Entry.Addend));
+        RW.write(uint32_t(Entry.Addend));
 
       if (OWriter.TargetObjectWriter->getEMachine() == ELF::EM_MIPS) {
         if (uint32_t RType =
                 OWriter.TargetObjectWriter->getRType2(Entry.Type)) {
-          write(uint32_t(Entry.Offset));
+          RW.write(uint32_t(Entry.Offset));
 
           ERE32.setSymbolAndType(0, RType);
-          write(ERE32.r_info);
-          write(uint32_t(0));
+          RW.write(ERE32.r_info);
+          RW.write(uint32_t(0));
         }
         if (uint32_t RType =
                 OWriter.TargetObjectWriter->getRType3(Entry.Type)) {
-          write(uint32_t(Entry.Offset));
+          RW.write(uint32_t(Entry.Offset));
 
           ERE32.setSymbolAndType(0, RType);
-          write(ERE32.r_info);
-          write(uint32_t(0));
+          RW.write(ERE32.r_info);
+          RW.write(uint32_t(0));
         }
       }
     }
@@ -1059,6 +1138,30 @@ uint64_t ELFWriter::writeObject(MCAssembler &Asm, const MCAsmLayout &Layout) {
 
   std::map<const MCSymbol *, std::vector<const MCSectionELF *>> GroupMembers;
 
+  auto IsWritten = [&](const MCSectionELF &Section) {
+    if (Mode == NonDwoOnly && isDwoSection(Section))
+      return false;
+    if (Mode == DwoOnly && !isDwoSection(Section))
+      return false;
+    return true;
+  };
+
+  // The layout is final, so the contents of the sections are independent of
+  // each other and can be encoded concurrently. Sections that get compressed
+  // are renamed or flagged while they are written, so they stay serial.
+  if (WriterThreads > 1) {
+    std::vector<const MCSectionELF *> Sections;
+    for (MCSection &Sec : Asm) {
+      const MCSectionELF &Section = static_cast<MCSectionELF &>(Sec);
+      if (IsWritten(Section) && !shouldCompressSection(Asm, Section))
+        Sections.push_back(&Section);
+    }
+    encodeSections(Sections,
+                   [&](const MCSectionELF &Section, raw_ostream &OS) {
+                     Asm.writeSectionData(OS, &Section, Layout);
+                   });
+  }
+
   // Write out the ELF header ...
   writeHeader(Asm);
 
@@ -1068,9 +1171,7 @@ uint64_t ELFWriter::writeObject(MCAssembler &Asm, const MCAsmLayout &Layout) {
   std::vector<MCSectionELF *> Relocations;
   for (MCSection &Sec : Asm) {
     MCSectionELF &Section = static_cast<MCSectionELF &>(Sec);
-    if (Mode == NonDwoOnly && isDwoSection(Section))
-      continue;
-    if (Mode == DwoOnly && !isDwoSection(Section))
+    if (!IsWritten(Section))
       continue;
 
     align(Section.getAlignment());
@@ -1151,14 +1252,28 @@ uint64_t ELFWriter::writeObject(MCAssembler &Asm, const MCAsmLayout &Layout) {
     computeSymbolTable(Asm, Layout, SectionIndexMap, RevGroupMap,
                        SectionOffsets);
 
+    // With the symbol indices known, the relocation tables are independent of
+    // each other too.
+    if (WriterThreads > 1)
+      encodeSections(
+          std::vector<const MCSectionELF *>(Relocations.begin(),
+                                            Relocations.end()),
+          [&](const MCSectionELF &RelSection, raw_ostream &OS) {
+            writeRelocations(
+                Asm, cast<MCSectionELF>(*RelSection.getAssociatedSection()),
+                OS);
+          });
+
     for (MCSectionELF *RelSection : Relocations) {
       align(RelSection->getAlignment());
 
       // Remember the offset into the file for this section.
       uint64_t SecStart = W.OS.tell();
 
-      writeRelocations(Asm,
-                       cast<MCSectionELF>(*RelSection->getAssociatedSection()));
+      if (!writePreEncoded(*RelSection))
+        writeRelocations(
+            Asm, cast<MCSectionELF>(*RelSection->getAssociatedSection()),
+            W.OS);
 
       uint64_t SecEnd = W.OS.tell();
       SectionOffsets[RelSection] = std::make_pair(SecStart, SecEnd);
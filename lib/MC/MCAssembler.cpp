@@ -68,6 +68,7 @@ STATISTIC(FragmentLayouts, "Number of fragment layouts");
 STATISTIC(ObjectBytes, "Number of emitted object file bytes");
 STATISTIC(RelaxationSteps, "Number of assembler layout and relaxation steps");
 STATISTIC(RelaxedInstructions, "Number of relaxed instructions");
+STATISTIC(RelaxationChecks, "Number of fragments checked for relaxation");
 STATISTIC(PaddingFragmentsRelaxations,
           "Number of Padding Fragments relaxations");
 STATISTIC(PaddingFragmentsBytes,
@@ -1030,43 +1031,51 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec) {
   // invalidated because their offset is going to change.
   MCFragment *FirstRelaxedFragment = nullptr;
 
-  // Attempt to relax all the fragments in the section.
-  for (MCSection::iterator I = Sec.begin(), IE = Sec.end(); I != IE; ++I) {
+  // Attempt to relax the fragments in the section that may need it, which are
+  // the ones spanning a fragment that was resized in the previous pass.
+  SmallVector<MCFragment *, 64> Fragments;
+  Layout.getFragmentsToRelax(Sec, Fragments);
+  for (MCFragment *F : Fragments) {
+    ++stats::RelaxationChecks;
+
     // Check if this is a fragment that needs relaxation.
     bool RelaxedFrag = false;
-    switch(I->getKind()) {
+    switch(F->getKind()) {
     default:
       break;
     case MCFragment::FT_Relaxable:
       assert(!getRelaxAll() &&
              "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
+      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(F));
       break;
     case MCFragment::FT_Dwarf:
       RelaxedFrag = relaxDwarfLineAddr(Layout,
-                                       *cast<MCDwarfLineAddrFragment>(I));
+                                       *cast<MCDwarfLineAddrFragment>(F));
       break;
     case MCFragment::FT_DwarfFrame:
       RelaxedFrag =
         relaxDwarfCallFrameFragment(Layout,
-                                    *cast<MCDwarfCallFrameFragment>(I));
+                                    *cast<MCDwarfCallFrameFragment>(F));
       break;
     case MCFragment::FT_LEB:
-      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
+      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(F));
       break;
     case MCFragment::FT_Padding:
-      RelaxedFrag = relaxPaddingFragment(Layout, *cast<MCPaddingFragment>(I));
+      RelaxedFrag = relaxPaddingFragment(Layout, *cast<MCPaddingFragment>(F));
       break;
     case MCFragment::FT_CVInlineLines:
       RelaxedFrag =
-          relaxCVInlineLineTable(Layout, *cast<MCCVInlineLineTableFragment>(I));
+          relaxCVInlineLineTable(Layout, *cast<MCCVInlineLineTableFragment>(F));
       break;
     case MCFragment::FT_CVDefRange:
-      RelaxedFrag = relaxCVDefRange(Layout, *cast<MCCVDefRangeFragment>(I));
+      RelaxedFrag = relaxCVDefRange(Layout, *cast<MCCVDefRangeFragment>(F));
       break;
     }
-    if (RelaxedFrag && !FirstRelaxedFragment)
-      FirstRelaxedFragment = &*I;
+    if (!RelaxedFrag)
+      continue;
+    Layout.noteFragmentRelaxed(F);
+    if (!FirstRelaxedFragment)
+      FirstRelaxedFragment = F;
   }
   if (FirstRelaxedFragment) {
     Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
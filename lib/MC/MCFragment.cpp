@@ -8,25 +8,32 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/MC/MCFragment.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/Config/llvm-config.h"
+#include "llvm/MC/MCAsmBackend.h"
 #include "llvm/MC/MCAsmLayout.h"
 #include "llvm/MC/MCAssembler.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCExpr.h"
 #include "llvm/MC/MCFixup.h"
+#include "llvm/MC/MCFixupKindInfo.h"
 #include "llvm/MC/MCSection.h"
 #include "llvm/MC/MCSymbol.h"
 #include "llvm/MC/MCValue.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <tuple>
 #include <utility>
+#include <vector>
 
 using namespace llvm;
 
@@ -188,6 +195,218 @@ uint64_t MCAsmLayout::getSectionFileSize(const MCSection *Sec) const {
   return getSectionAddressSize(Sec);
 }
 
+/// The fragments of a section that relaxation has to look at. Fragments with
+/// a known span are kept sorted by the start of their span, with a max-tree
+/// over the span ends, so that the fragments spanning a resized fragment can
+/// be found without walking the whole section.
+struct MCAsmLayout::SectionRelaxState {
+  /// Fragments whose fixups are all PC-relative references into this
+  /// section, and the first fragment in layout order that each one spans.
+  std::vector<MCFragment *> Spanned;
+  std::vector<unsigned> SpanBegin;
+
+  /// Max-tree over one past the last fragment each fragment in Spanned
+  /// spans, or 0 once that fragment can't be relaxed anymore.
+  std::vector<unsigned> SpanEndTree;
+  unsigned TreeSize = 0;
+
+  /// The pass in which each fragment in Spanned was last collected.
+  std::vector<unsigned> CollectedIn;
+
+  /// Fragments that have to be checked in every pass.
+  std::vector<MCFragment *> AlwaysChecked;
+
+  /// Layout orders of the fragments whose size depends on their offset.
+  std::vector<unsigned> OffsetDependent;
+
+  /// Layout orders of the fragments resized in the current pass.
+  SmallVector<unsigned, 16> Resized;
+
+  unsigned Pass = 0;
+};
+
+MCAsmLayout::~MCAsmLayout() = default;
+
+/// Compute the range of fragments, in layout order, whose sizes determine the
+/// values of the fixups of \p F. Returns false when those values may change
+/// whenever any fragment of the section moves.
+static bool getFixupSpan(const MCAssembler &Asm, const MCRelaxableFragment &F,
+                         unsigned &Begin, unsigned &End) {
+  Begin = End = F.getLayoutOrder();
+  for (const MCFixup &Fixup : F.getFixups()) {
+    const MCFixupKindInfo &Info =
+        Asm.getBackend().getFixupKindInfo(Fixup.getKind());
+    if (!(Info.Flags & MCFixupKindInfo::FKF_IsPCRel) ||
+        (Info.Flags & MCFixupKindInfo::FKF_IsAlignedDownTo32Bits))
+      return false;
+
+    MCValue Target;
+    if (!Fixup.getValue()->evaluateAsRelocatable(Target, nullptr, &Fixup))
+      return false;
+    const MCSymbolRefExpr *A = Target.getSymA();
+    if (!A || Target.getSymB() || A->getKind() != MCSymbolRefExpr::VK_None)
+      return false;
+    const MCSymbol &Sym = A->getSymbol();
+    if (Sym.isVariable() || !Sym.getFragment() ||
+        Sym.getFragment()->getParent() != F.getParent())
+      return false;
+
+    unsigned Order = Sym.getFragment()->getLayoutOrder();
+    Begin = std::min(Begin, Order);
+    End = std::max(End, Order);
+  }
+  return true;
+}
+
+MCAsmLayout::SectionRelaxState &MCAsmLayout::getRelaxState(MCSection &Sec) {
+  std::unique_ptr<SectionRelaxState> &State = RelaxStates[&Sec];
+  if (State)
+    return *State;
+  State = llvm::make_unique<SectionRelaxState>();
+
+  // With bundling, padding can change the size of any fragment, so check every
+  // relaxable fragment in every pass.
+  bool UseSpans = !Assembler.isBundlingEnabled();
+  using SpanEntry = std::tuple<unsigned, unsigned, MCFragment *>;
+  std::vector<SpanEntry> Spans;
+  for (MCFragment &F : Sec) {
+    switch (F.getKind()) {
+    default:
+      break;
+    case MCFragment::FT_Fill: {
+      int64_t NumValues;
+      if (cast<MCFillFragment>(F).getNumValues().evaluateAsAbsolute(NumValues))
+        break;
+      State->OffsetDependent.push_back(F.getLayoutOrder());
+      break;
+    }
+    case MCFragment::FT_Align:
+    case MCFragment::FT_Org:
+      State->OffsetDependent.push_back(F.getLayoutOrder());
+      break;
+    case MCFragment::FT_Relaxable: {
+      unsigned Begin, End;
+      if (UseSpans &&
+          getFixupSpan(Assembler, cast<MCRelaxableFragment>(F), Begin, End)) {
+        Spans.emplace_back(Begin, End, &F);
+        break;
+      }
+      State->AlwaysChecked.push_back(&F);
+      break;
+    }
+    case MCFragment::FT_Dwarf:
+    case MCFragment::FT_DwarfFrame:
+    case MCFragment::FT_LEB:
+    case MCFragment::FT_Padding:
+    case MCFragment::FT_CVInlineLines:
+    case MCFragment::FT_CVDefRange:
+      State->AlwaysChecked.push_back(&F);
+      break;
+    }
+  }
+
+  llvm::sort(Spans.begin(), Spans.end(),
+             [](const SpanEntry &L, const SpanEntry &R) {
+               return std::get<0>(L) < std::get<0>(R);
+             });
+  State->TreeSize = PowerOf2Ceil(std::max<size_t>(Spans.size(), 1));
+  State->SpanEndTree.assign(2 * State->TreeSize, 0);
+  State->CollectedIn.assign(Spans.size(), 0);
+  for (unsigned I = 0, E = Spans.size(); I != E; ++I) {
+    State->SpanBegin.push_back(std::get<0>(Spans[I]));
+    State->Spanned.push_back(std::get<2>(Spans[I]));
+    State->SpanEndTree[State->TreeSize + I] = std::get<1>(Spans[I]) + 1;
+  }
+  for (unsigned I = State->TreeSize - 1; I != 0; --I)
+    State->SpanEndTree[I] =
+        std::max(State->SpanEndTree[2 * I], State->SpanEndTree[2 * I + 1]);
+  return *State;
+}
+
+/// Collect the indices below \p Limit in the max-tree \p Tree whose span ends
+/// at or after \p Order.
+static void collectSpanning(const std::vector<unsigned> &Tree, unsigned Node,
+                            unsigned Lo, unsigned Hi, unsigned Limit,
+                            unsigned Order, SmallVectorImpl<unsigned> &Out) {
+  if (Lo >= Limit || Tree[Node] <= Order)
+    return;
+  if (Hi - Lo == 1) {
+    Out.push_back(Lo);
+    return;
+  }
+  unsigned Mid = Lo + (Hi - Lo) / 2;
+  collectSpanning(Tree, 2 * Node, Lo, Mid, Limit, Order, Out);
+  collectSpanning(Tree, 2 * Node + 1, Mid, Hi, Limit, Order, Out);
+}
+
+void MCAsmLayout::getFragmentsToRelax(MCSection &Sec,
+                                      SmallVectorImpl<MCFragment *> &Fragments) {
+  SectionRelaxState &State = getRelaxState(Sec);
+  unsigned Pass = ++State.Pass;
+  const MCAsmBackend &Backend = Assembler.getBackend();
+
+  // A relaxable instruction that was relaxed into a form that doesn't need
+  // relaxation can be forgotten.
+  auto IsFinal = [&](const MCFragment *F) {
+    const auto *RF = dyn_cast<MCRelaxableFragment>(F);
+    return RF && !Backend.mayNeedRelaxation(RF->getInst(),
+                                            *RF->getSubtargetInfo());
+  };
+  auto Collect = [&](unsigned Idx) {
+    if (State.CollectedIn[Idx] == Pass)
+      return;
+    State.CollectedIn[Idx] = Pass;
+    MCFragment *F = State.Spanned[Idx];
+    if (!IsFinal(F)) {
+      Fragments.push_back(F);
+      return;
+    }
+    unsigned Node = State.TreeSize + Idx;
+    State.SpanEndTree[Node] = 0;
+    for (Node /= 2; Node != 0; Node /= 2)
+      State.SpanEndTree[Node] = std::max(State.SpanEndTree[2 * Node],
+                                         State.SpanEndTree[2 * Node + 1]);
+  };
+
+  if (Pass == 1) {
+    for (unsigned I = 0, E = State.Spanned.size(); I != E; ++I)
+      Collect(I);
+  } else if (!State.Resized.empty()) {
+    // Everything from the first resized fragment on may have moved, so the
+    // fragments whose size depends on their offset may have been resized too.
+    SmallVector<unsigned, 16> Resized;
+    std::swap(Resized, State.Resized);
+    unsigned FirstResized = *std::min_element(Resized.begin(), Resized.end());
+    Resized.append(std::lower_bound(State.OffsetDependent.begin(),
+                                    State.OffsetDependent.end(), FirstResized),
+                   State.OffsetDependent.end());
+
+    SmallVector<unsigned, 16> Spanning;
+    for (unsigned Order : Resized) {
+      unsigned Limit = std::upper_bound(State.SpanBegin.begin(),
+                                        State.SpanBegin.end(), Order) -
+                       State.SpanBegin.begin();
+      collectSpanning(State.SpanEndTree, 1, 0, State.TreeSize, Limit, Order,
+                      Spanning);
+      for (unsigned Idx : Spanning)
+        Collect(Idx);
+      Spanning.clear();
+    }
+  }
+
+  State.AlwaysChecked.erase(llvm::remove_if(State.AlwaysChecked, IsFinal),
+                            State.AlwaysChecked.end());
+  Fragments.append(State.AlwaysChecked.begin(), State.AlwaysChecked.end());
+  llvm::sort(Fragments.begin(), Fragments.end(),
+             [](const MCFragment *L, const MCFragment *R) {
+               return L->getLayoutOrder() < R->getLayoutOrder();
+             });
+}
+
+void MCAsmLayout::noteFragmentRelaxed(const MCFragment *F) {
+  RelaxStates[F->getParent()]->Resized.push_back(F->getLayoutOrder());
+}
+
 uint64_t llvm::computeBundlePadding(const MCAssembler &Assembler,
                                     const MCEncodedFragment *F,
                                     uint64_t FOffset, uint64_t FSize) {
@@ -9,11 +9,13 @@
 
 #include "llvm/MC/StringTableBuilder.h"
 #include "llvm/ADT/CachedHashString.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/BinaryFormat/COFF.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
 #include <cstddef>
@@ -116,6 +118,72 @@ tailcall:
   }
 }
 
+// The last two characters of a string, as a key that orders strings the way the
+// first two levels of multikeySort do, except that it is ascending.
+static unsigned charTailKey(StringPair *P) {
+  return (charTailAt(P, 0) + 1) * 257 + (charTailAt(P, 1) + 1);
+}
+
+// Tables with at least this many strings are sorted on several threads.
+static const size_t ParallelSortThreshold = 1 << 16;
+
+// Sort Vec like multikeySort(Vec, Pos). Most of the work is done on keys that
+// pack the characters at positions [Pos, Pos + 7) from the end, so that the
+// strings are only looked at again to break ties between equal keys.
+static void keyedMultikeySort(MutableArrayRef<StringPair *> Vec, int Pos) {
+  std::vector<std::pair<uint64_t, StringPair *>> Keyed;
+  Keyed.reserve(Vec.size());
+  for (StringPair *P : Vec) {
+    uint64_t Key = 0;
+    for (int I = 0; I != 7; ++I)
+      Key = (Key << 9) | (charTailAt(P, Pos + I) + 1);
+    Keyed.emplace_back(Key, P);
+  }
+  llvm::sort(Keyed.begin(), Keyed.end(),
+             [](const std::pair<uint64_t, StringPair *> &L,
+                const std::pair<uint64_t, StringPair *> &R) {
+               return L.first > R.first;
+             });
+
+  for (size_t I = 0, E = Keyed.size(); I != E;) {
+    size_t J = I + 1;
+    while (J != E && Keyed[J].first == Keyed[I].first)
+      ++J;
+    for (size_t K = I; K != J; ++K)
+      Vec[K] = Keyed[K].second;
+    if (J - I > 1)
+      multikeySort(Vec.slice(I, J - I), Pos + 7);
+    I = J;
+  }
+}
+
+// Sort Vec into the same order as multikeySort(Vec, 0), on several threads.
+// The strings are bucketed by their last two characters with a counting sort,
+// and the buckets, which multikeySort would never compare with each other, are
+// then sorted independently.
+static void parallelMultikeySort(std::vector<StringPair *> &Vec) {
+  const unsigned NumKeys = 257 * 257;
+  std::vector<size_t> BucketBegin(NumKeys + 1);
+  for (StringPair *P : Vec)
+    ++BucketBegin[NumKeys - charTailKey(P)];
+  for (unsigned I = 1; I <= NumKeys; ++I)
+    BucketBegin[I] += BucketBegin[I - 1];
+
+  // Scatter the strings, placing the buckets in descending key order.
+  std::vector<StringPair *> Sorted(Vec.size());
+  std::vector<size_t> Next(BucketBegin.begin(), BucketBegin.end() - 1);
+  for (StringPair *P : Vec)
+    Sorted[Next[NumKeys - 1 - charTailKey(P)]++] = P;
+
+  MutableArrayRef<StringPair *> All(Sorted);
+  parallel::for_each_n(parallel::par, 0u, NumKeys, [&](unsigned I) {
+    size_t Begin = BucketBegin[I];
+    if (BucketBegin[I + 1] - Begin > 1)
+      keyedMultikeySort(All.slice(Begin, BucketBegin[I + 1] - Begin), 2);
+  });
+  Vec = std::move(Sorted);
+}
+
 void StringTableBuilder::finalize() {
   assert(K != DWARF);
   finalizeStringTable(/*Optimize=*/true);
@@ -134,7 +202,10 @@ void StringTableBuilder::finalizeStringTable(bool Optimize) {
     for (StringPair &P : StringIndexMap)
       Strings.push_back(&P);
 
-    multikeySort(Strings, 0);
+    if (Strings.size() >= ParallelSortThreshold)
+      parallelMultikeySort(Strings);
+    else
+      multikeySort(Strings, 0);
     initSize();
 
     StringRef Previous;
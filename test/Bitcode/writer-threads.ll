@@ -0,0 +1,95 @@
+; Encoding function blocks on several threads must not change the output.
+; RUN: llvm-as -module-hash < %s -o %t.serial.bc
+; RUN: llvm-as -module-hash -bitcode-writer-threads=3 < %s -o %t.parallel.bc
+; RUN: cmp %t.serial.bc %t.parallel.bc
+; RUN: llvm-dis < %t.parallel.bc | FileCheck %s
+
+; Use-list order preservation falls back to serial emission.
+; RUN: llvm-as -preserve-bc-uselistorder < %s -o %t.serial-uselist.bc
+; RUN: llvm-as -preserve-bc-uselistorder -bitcode-writer-threads=3 < %s \
+; RUN:   -o %t.parallel-uselist.bc
+; RUN: cmp %t.serial-uselist.bc %t.parallel-uselist.bc
+
+@table = global [2 x i8*] [i8* blockaddress(@indirect, %a), i8* blockaddress(@indirect, %b)]
+
+; CHECK: define i32 @sum(i32* %p, i32 %n)
+define i32 @sum(i32* %p, i32 %n) !dbg !6 {
+entry:
+  call void @llvm.dbg.value(metadata i32* %p, metadata !9, metadata !DIExpression()), !dbg !11
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %acc = phi i32 [ 0, %entry ], [ %acc.next, %loop ]
+  %gep = getelementptr inbounds i32, i32* %p, i32 %i
+  %v = load i32, i32* %gep, align 4, !dbg !11
+  %acc.next = add nsw i32 %acc, %v, !dbg !11
+  %i.next = add nuw i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %loop, !prof !12
+
+exit:
+  ret i32 %acc.next, !dbg !11
+}
+
+declare void @llvm.dbg.value(metadata, metadata, metadata)
+
+; CHECK: define void @indirect(i32 %x)
+define void @indirect(i32 %x) {
+  %t = getelementptr [2 x i8*], [2 x i8*]* @table, i32 0, i32 %x
+  %dest = load i8*, i8** %t
+  indirectbr i8* %dest, [label %a, label %b]
+a:
+  ret void
+b:
+  switch i32 %x, label %a [ i32 7, label %a
+                            i32 9, label %b ]
+}
+
+; CHECK: define double @fp(double %x, float %y)
+define double @fp(double %x, float %y) {
+  %e = fpext float %y to double
+  %m = fmul fast double %x, %e
+  %c = fadd double %m, 1.250000e+00
+  ret double %c
+}
+
+; CHECK: define i8* @str()
+define i8* @str() {
+  %s = alloca [4 x i8]
+  store [4 x i8] c"abc\00", [4 x i8]* %s
+  %r = bitcast [4 x i8]* %s to i8*
+  ret i8* %r
+}
+
+; CHECK: define void @calls()
+define void @calls() personality i32 (...)* @personality {
+  %r = invoke i32 @sum(i32* null, i32 0) to label %ok unwind label %lp
+ok:
+  call void @indirect(i32 %r) #0
+  ret void
+lp:
+  %l = landingpad { i8*, i32 } cleanup
+  resume { i8*, i32 } %l
+}
+
+declare i32 @personality(...)
+
+attributes #0 = { nounwind }
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!3, !4}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C99, file: !1, producer: "test", isOptimized: true, emissionKind: FullDebug, enums: !2)
+!1 = !DIFile(filename: "t.c", directory: "/")
+!2 = !{}
+!3 = !{i32 2, !"Debug Info Version", i32 3}
+!4 = !{i32 2, !"Dwarf Version", i32 4}
+!5 = !DISubroutineType(types: !2)
+!6 = distinct !DISubprogram(name: "sum", scope: !1, file: !1, line: 1, type: !5, isLocal: false, isDefinition: true, scopeLine: 1, isOptimized: true, unit: !0, retainedNodes: !2)
+!7 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!8 = !DIDerivedType(tag: DW_TAG_pointer_type, baseType: !7, size: 64)
+!9 = !DILocalVariable(name: "p", arg: 1, scope: !6, file: !1, line: 1, type: !8)
+!10 = !{}
+!11 = !DILocation(line: 2, column: 3, scope: !6)
+!12 = !{!"branch_weights", i32 1, i32 99}
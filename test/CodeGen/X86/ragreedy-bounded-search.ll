@@ -0,0 +1,105 @@
+; RUN: llc < %s -mtriple=x86_64-- -verify-machineinstrs -stats -o /dev/null \
+; RUN:   2>&1 | FileCheck %s --check-prefix=DEFAULT
+; RUN: llc < %s -mtriple=x86_64-- -verify-machineinstrs -stats -o /dev/null \
+; RUN:   -greedy-bounded-search -greedy-evict-search-budget=1 \
+; RUN:   -greedy-split-search-budget=1 -greedy-spill-placement-budget=2 \
+; RUN:   2>&1 | FileCheck %s --check-prefix=BOUNDED
+; REQUIRES: asserts
+
+; Sixteen values live across a chain of diamonds with calls. The unbounded
+; allocator evicts and splits around the calls; with tiny search budgets it
+; gives up on those searches and spills instead, and still produces valid code.
+
+; DEFAULT-NOT: budget
+; DEFAULT: 3 regalloc - Number of interferences evicted
+; DEFAULT: 1 regalloc - Number of split global live ranges
+; DEFAULT-NOT: budget
+
+; BOUNDED: 15 regalloc - Number of eviction searches stopped by the search budget
+; BOUNDED-NOT: Number of interferences evicted
+; BOUNDED-NOT: Number of split global live ranges
+; BOUNDED: 11 regalloc - Number of region split searches stopped by the search budget
+; BOUNDED: 22 spill-code-placement - Number of placements stopped by the node update budget
+
+declare void @f(i64)
+define i64 @bounded(i64* %p, i1 %c) {
+entry:
+  %a0 = load volatile i64, i64* %p
+  %a1 = load volatile i64, i64* %p
+  %a2 = load volatile i64, i64* %p
+  %a3 = load volatile i64, i64* %p
+  %a4 = load volatile i64, i64* %p
+  %a5 = load volatile i64, i64* %p
+  %a6 = load volatile i64, i64* %p
+  %a7 = load volatile i64, i64* %p
+  %a8 = load volatile i64, i64* %p
+  %a9 = load volatile i64, i64* %p
+  %a10 = load volatile i64, i64* %p
+  %a11 = load volatile i64, i64* %p
+  %a12 = load volatile i64, i64* %p
+  %a13 = load volatile i64, i64* %p
+  %a14 = load volatile i64, i64* %p
+  %a15 = load volatile i64, i64* %p
+  br label %b0
+b0:
+  br i1 %c, label %t0, label %e0
+t0:
+  call void @f(i64 %a1)
+  br label %j0
+e0:
+  %n0 = add i64 %a2, 0
+  br label %j0
+j0:
+  %m0 = phi i64 [%a2, %t0], [%n0, %e0]
+  br label %b1
+b1:
+  br i1 %c, label %t1, label %e1
+t1:
+  call void @f(i64 %m0)
+  br label %j1
+e1:
+  %n1 = add i64 %a11, 1
+  br label %j1
+j1:
+  %m1 = phi i64 [%a11, %t1], [%n1, %e1]
+  br label %b2
+b2:
+  br i1 %c, label %t2, label %e2
+t2:
+  call void @f(i64 %a5)
+  br label %j2
+e2:
+  %n2 = add i64 %a9, 2
+  br label %j2
+j2:
+  %m2 = phi i64 [%a9, %t2], [%n2, %e2]
+  br label %b3
+b3:
+  br i1 %c, label %t3, label %e3
+t3:
+  call void @f(i64 %a8)
+  br label %j3
+e3:
+  %n3 = add i64 %a6, 3
+  br label %j3
+j3:
+  %m3 = phi i64 [%a6, %t3], [%n3, %e3]
+  br label %b4
+b4:
+  %s1 = add i64 %a0, %a1
+  %s2 = add i64 %s1, %m0
+  %s3 = add i64 %s2, %a3
+  %s4 = add i64 %s3, %a4
+  %s5 = add i64 %s4, %a5
+  %s6 = add i64 %s5, %m3
+  %s7 = add i64 %s6, %a7
+  %s8 = add i64 %s7, %a8
+  %s9 = add i64 %s8, %m2
+  %s10 = add i64 %s9, %a10
+  %s11 = add i64 %s10, %m1
+  %s12 = add i64 %s11, %a12
+  %s13 = add i64 %s12, %a13
+  %s14 = add i64 %s13, %a14
+  %s15 = add i64 %s14, %a15
+  ret i64 %s15
+}
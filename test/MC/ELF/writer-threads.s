@@ -0,0 +1,54 @@
+// Encoding sections and relocations on several threads must not change the
+// output.
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux %s -o %t.serial.o
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux -elf-writer-threads=3 \
+// RUN:   %s -o %t.parallel.o
+// RUN: cmp %t.serial.o %t.parallel.o
+// RUN: llvm-readobj -sections -relocations %t.parallel.o | FileCheck %s
+
+// Same for 32-bit REL relocations.
+// RUN: llvm-mc -filetype=obj -triple i386-pc-linux %s -o %t.serial32.o
+// RUN: llvm-mc -filetype=obj -triple i386-pc-linux -elf-writer-threads=3 \
+// RUN:   %s -o %t.parallel32.o
+// RUN: cmp %t.serial32.o %t.parallel32.o
+
+// CHECK:      Name: .text.f
+// CHECK:      Name: .rela.text.f
+// CHECK:      Name: .group
+// CHECK:      Name: .text.g
+// CHECK:      Name: .rela.text.g
+// CHECK:      Relocations [
+// CHECK-NEXT:   Section ({{[0-9]+}}) .rela.text.f {
+// CHECK-NEXT:     0x1 R_X86_64_PLT32 g 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:     0x8 R_X86_64_32S .data 0x4
+// CHECK-NEXT:   }
+// CHECK-NEXT:   Section ({{[0-9]+}}) .rela.text.g {
+// CHECK-NEXT:     0x1 R_X86_64_PLT32 f 0xFFFFFFFFFFFFFFFC
+// CHECK-NEXT:   }
+// CHECK-NEXT:   Section ({{[0-9]+}}) .rela.data {
+// CHECK-NEXT:     0x0 R_X86_64_32 f 0x0
+// CHECK-NEXT:     0x4 R_X86_64_32 g 0x0
+// CHECK-NEXT:   }
+// CHECK-NEXT: ]
+
+  .section .text.f,"ax",@progbits
+  .globl f
+f:
+  call g@PLT
+  movl $0, .data+4
+  .p2align 4
+  ret
+
+  .section .text.g,"axG",@progbits,g,comdat
+  .globl g
+g:
+  call f@PLT
+  ret
+
+  .data
+  .long f
+  .long g
+  .zero 16
+
+  .bss
+  .zero 32
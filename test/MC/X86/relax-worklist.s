@@ -0,0 +1,53 @@
+# RUN: llvm-mc -triple=x86_64-pc-linux -filetype=obj %s -o %t -stats 2>&1 \
+# RUN:   | FileCheck %s -check-prefix=STATS
+# RUN: llvm-objdump -d %t | FileCheck %s
+# REQUIRES: asserts
+
+# Relaxation only rechecks the branches that span a fragment which changed
+# size in the previous pass, including alignment that changed because of it.
+
+# Each branch in the chain is pushed out of range by relaxing the next one, so
+# this takes four passes, and each pass after the first checks one branch.
+# CHECK-LABEL: {{^}}chain:
+# CHECK-NEXT:  0: e9 {{.*}} jmp
+# CHECK:      5a: e9 {{.*}} jmp
+# CHECK:      b4: e9 {{.*}} jmp
+# CHECK:     10e: e9 {{.*}} jmp
+  .section .text.chain,"ax",@progbits
+chain:
+  jmp .Lc0
+  .skip 85, 0x90
+  jmp .Lc1
+  .skip 40, 0x90
+.Lc0:
+  .skip 45, 0x90
+  jmp .Lc2
+  .skip 40, 0x90
+.Lc1:
+  .skip 45, 0x90
+  jmp .Lfar
+  .skip 40, 0x90
+.Lc2:
+  .skip 245, 0x90
+.Lfar:
+  ret
+
+# Relaxing the first branch grows the alignment padding that the backward
+# branch spans, which pushes it out of range.
+# CHECK-LABEL: {{^}}align:
+# CHECK-NEXT:  0: e9 {{.*}} jmp
+# CHECK:      c2: e9 {{.*}} jmp
+  .section .text.align,"ax",@progbits
+align:
+  jmp .Lfar2
+  .skip 62, 0x90
+.Lback:
+  .p2align 4
+  .skip 114, 0x90
+  jmp .Lback
+  .skip 200, 0x90
+.Lfar2:
+  ret
+
+# STATS: 10 assembler - Number of fragments checked for relaxation
+# STATS: 6 assembler - Number of relaxed instructions
@@ -0,0 +1,64 @@
+; RUN: opt -module-summary %s -o %t.bc -bitcode-mdindex-threshold=0
+; RUN: opt -module-summary %p/Inputs/lazyload_metadata_cu.ll -o %t2.bc
+; RUN: llvm-lto -thinlto-action=thinlink -o %t3.bc %t.bc %t2.bc
+; REQUIRES: asserts
+
+; Check that importing @imported does not load the enums, retained types and
+; globals listed on its compile unit, which the IRMover drops anyway.
+
+; RUN: llvm-lto -thinlto-action=import %t2.bc -thinlto-index=%t3.bc \
+; RUN:          -o - -stats 2>%t.stats | llvm-dis -o - | FileCheck %s
+; RUN: FileCheck %s -check-prefix=STATS < %t.stats
+; STATS: 3 bitcode-reader  - Number of DICompileUnit lists not loaded when importing
+; STATS: 73 bitcode-reader  - Number of Metadata records loaded
+; STATS: 8 bitcode-reader  - Number of MDStrings loaded
+
+; CHECK: define available_externally void @imported(){{.*}} !dbg ![[SP:[0-9]+]]
+; CHECK: !DICompileUnit(
+; CHECK-NOT: enums:
+; CHECK-NOT: retainedTypes:
+; CHECK-NOT: globals:
+; CHECK-SAME: ){{$}}
+; CHECK: ![[SP]] = distinct !DISubprogram(name: "imported"
+; CHECK-NOT: name: "unused_enum"
+; CHECK-NOT: name: "Retained"
+; CHECK-NOT: name: "global"
+
+target datalayout = "e-m:o-i64:64-f80:128-n8:16:32:64-S128"
+target triple = "x86_64-apple-macosx10.11.0"
+
+@global = global i32 0, align 4, !dbg !9
+
+define void @imported() !dbg !12 {
+  ret void, !dbg !15
+}
+
+; Not imported: its debug info must not be loaded either.
+define void @other() !dbg !16 {
+  ret void, !dbg !17
+}
+
+!llvm.dbg.cu = !{!0}
+!llvm.module.flags = !{!18, !19}
+
+!0 = distinct !DICompileUnit(language: DW_LANG_C_plus_plus, file: !1, producer: "clang", isOptimized: true, runtimeVersion: 0, emissionKind: FullDebug, enums: !2, retainedTypes: !6, globals: !8)
+!1 = !DIFile(filename: "lazyload_metadata_cu.cc", directory: "/")
+!2 = !{!3}
+!3 = !DICompositeType(tag: DW_TAG_enumeration_type, name: "unused_enum", file: !1, line: 1, size: 32, elements: !4, identifier: "_ZTS11unused_enum")
+!4 = !{!5}
+!5 = !DIEnumerator(name: "A", value: 0)
+!6 = !{!7}
+!7 = !DICompositeType(tag: DW_TAG_structure_type, name: "Retained", file: !1, line: 2, size: 32, elements: !20, identifier: "_ZTS8Retained")
+!8 = !{!9}
+!9 = !DIGlobalVariableExpression(var: !10, expr: !DIExpression())
+!10 = !DIGlobalVariable(name: "global", scope: !0, file: !1, line: 3, type: !11, isLocal: false, isDefinition: true)
+!11 = !DIBasicType(name: "int", size: 32, encoding: DW_ATE_signed)
+!12 = distinct !DISubprogram(name: "imported", scope: !1, file: !1, line: 4, type: !13, isLocal: false, isDefinition: true, scopeLine: 4, isOptimized: true, unit: !0, retainedNodes: !20)
+!13 = !DISubroutineType(types: !14)
+!14 = !{null}
+!15 = !DILocation(line: 4, column: 1, scope: !12)
+!16 = distinct !DISubprogram(name: "other", scope: !1, file: !1, line: 5, type: !13, isLocal: false, isDefinition: true, scopeLine: 5, isOptimized: true, unit: !0, retainedNodes: !20)
+!17 = !DILocation(line: 5, column: 1, scope: !16)
+!18 = !{i32 2, !"Debug Info Version", i32 3}
+!19 = !{i32 1, !"wchar_size", i32 4}
+!20 = !{}
@@ -37,6 +37,7 @@
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/SHA1.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
 using namespace llvm;
@@ -66,6 +67,10 @@ static cl::opt<bool>
   ShowBinaryBlobs("show-binary-blobs",
                   cl::desc("Print binary blobs using hex escapes"));
 
+static cl::opt<bool>
+  ShowThroughput("show-throughput",
+                 cl::desc("Report how fast the bitstream was decoded"));
+
 static cl::opt<std::string> CheckHash(
     "check-hash",
     cl::desc("Check module hash using the argument as a string table"));
@@ -865,6 +870,7 @@ static int AnalyzeBitcode() {
   }
 
   unsigned NumTopBlocks = 0;
+  TimeRecord StartTime = TimeRecord::getCurrentTime(/*Start=*/true);
 
   // Parse the top-level structure.  We only allow blocks at the top-level.
   while (!Stream.AtEndOfStream()) {
@@ -879,6 +885,9 @@ static int AnalyzeBitcode() {
     ++NumTopBlocks;
   }
 
+  TimeRecord DecodeTime = TimeRecord::getCurrentTime(/*Start=*/false);
+  DecodeTime -= StartTime;
+
   if (Dump) outs() << "\n\n";
 
   uint64_t BufferSizeBits = Stream.getBitcodeBytes().size() * CHAR_BIT;
@@ -903,6 +912,21 @@ static int AnalyzeBitcode() {
     break;
   }
   outs() << "  # Toplevel Blocks: " << NumTopBlocks << "\n";
+  if (ShowThroughput) {
+    // This includes the time spent collecting statistics, and dumping the
+    // stream with -dump.
+    uint64_t NumRecords = 0;
+    for (const auto &Stats : BlockIDStats)
+      NumRecords += Stats.second.NumRecords;
+    double Seconds = DecodeTime.getWallTime();
+    outs() << "        Decode time: " << format("%.4f s", Seconds) << "\n";
+    if (Seconds > 0)
+      outs() << "  Decode throughput: "
+             << format("%.1f MB/s, %.0f records/s",
+                       Stream.getBitcodeBytes().size() / Seconds / 1e6,
+                       NumRecords / Seconds)
+             << "\n";
+  }
   outs() << "\n";
 
   // Emit per-block stats.
@@ -14,6 +14,7 @@
 #include "llvm/Bitcode/BitcodeWriter.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
+#include "llvm/IR/ValueArena.h"
 #include "llvm/IR/Verifier.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/Error.h"
@@ -122,6 +123,61 @@ TEST(BitReaderTest, MaterializeFunctionsOutOfOrder) {
   EXPECT_FALSE(verifyModule(*M, &dbgs()));
 }
 
+// Tests that function bodies materialized in a context that opted into arena
+// allocation are recycled once the module that owns them goes away.
+TEST(BitReaderTest, MaterializeFunctionsIntoArena) {
+  SmallString<1024> Mem;
+  LLVMContext Context;
+  Context.setArenaAllocateFunctionBodies(true);
+  ValueArena *Arena;
+  {
+    ValueArenaScope Scope(Context);
+    Arena = ValueArena::getCurrent();
+  }
+  ASSERT_NE(nullptr, Arena);
+
+  std::unique_ptr<Module> M = getLazyModuleFromAssembly(
+      Context, Mem, "define i32 @f(i32 %a, i1 %c) {\n"
+                    "entry:\n"
+                    "  br label %loop\n"
+                    "loop:\n"
+                    "  %x = phi i32 [ %a, %entry ], [ %y, %loop ]\n"
+                    "  %y = mul i32 %x, %a\n"
+                    "  br i1 %c, label %loop, label %exit\n"
+                    "exit:\n"
+                    "  ret i32 %y\n"
+                    "}\n"
+                    "define i32 @g(i32 %a) {\n"
+                    "  %b = add i32 %a, %a\n"
+                    "  ret i32 %b\n"
+                    "}\n");
+  EXPECT_EQ(0u, Arena->getBytesInUse());
+
+  ASSERT_FALSE(M->getFunction("f")->materialize());
+  size_t BytesInUseForF = Arena->getBytesInUse();
+  EXPECT_NE(0u, BytesInUseForF);
+  ASSERT_FALSE(M->getFunction("g")->materialize());
+  EXPECT_GT(Arena->getBytesInUse(), BytesInUseForF);
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+
+  // Deleting the module returns the bodies to the arena.
+  M.reset();
+  EXPECT_EQ(0u, Arena->getBytesInUse());
+  EXPECT_EQ(0u, Arena->getNumRecycled());
+  size_t TotalMemory = Arena->getTotalMemory();
+  EXPECT_NE(0u, TotalMemory);
+
+  // Materializing the same bodies again reuses that storage.
+  Expected<std::unique_ptr<Module>> ModuleOrErr =
+      getLazyBitcodeModule(MemoryBufferRef(Mem.str(), "test"), Context);
+  ASSERT_TRUE(!!ModuleOrErr);
+  M = std::move(*ModuleOrErr);
+  ASSERT_FALSE(M->materializeAll());
+  EXPECT_FALSE(verifyModule(*M, &dbgs()));
+  EXPECT_NE(0u, Arena->getNumRecycled());
+  EXPECT_EQ(TotalMemory, Arena->getTotalMemory());
+}
+
 TEST(BitReaderTest, MaterializeFunctionsForBlockAddr) { // PR11677
   SmallString<1024> Mem;
 
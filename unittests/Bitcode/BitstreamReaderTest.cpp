@@ -140,6 +140,81 @@ TEST(BitstreamReaderTest, readRecordWithBlobWhileStreaming) {
   }
 }
 
+TEST(BitstreamReaderTest, blockInfoAbbrevsInNestedBlocks) {
+  const unsigned BlockID = bitc::FIRST_APPLICATION_BLOCKID;
+  auto makeAbbrev = [](unsigned RecordID, unsigned Width) {
+    auto Abbrev = std::make_shared<BitCodeAbbrev>();
+    Abbrev->Add(BitCodeAbbrevOp(RecordID));
+    Abbrev->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Fixed, Width));
+    return Abbrev;
+  };
+
+  // Write a block with a nested block of the same ID. Both blocks inherit an
+  // abbreviation from the block info and define one of their own, which gets
+  // the same ID in both.
+  SmallVector<char, 64> Buffer;
+  unsigned SharedID, LocalID;
+  {
+    BitstreamWriter Stream(Buffer);
+    Stream.EnterBlockInfoBlock();
+    SharedID = Stream.EmitBlockInfoAbbrev(BlockID, makeAbbrev(1, 8));
+    Stream.ExitBlock();
+
+    Stream.EnterSubblock(BlockID, 3);
+    LocalID = Stream.EmitAbbrev(makeAbbrev(2, 4));
+    Stream.EnterSubblock(BlockID, 3);
+    ASSERT_EQ(LocalID, Stream.EmitAbbrev(makeAbbrev(3, 16)));
+    Stream.EmitRecord(1, ArrayRef<unsigned>(10u), SharedID);
+    Stream.EmitRecord(3, ArrayRef<unsigned>(1000u), LocalID);
+    Stream.ExitBlock();
+    Stream.EmitRecord(1, ArrayRef<unsigned>(20u), SharedID);
+    Stream.EmitRecord(2, ArrayRef<unsigned>(5u), LocalID);
+    Stream.ExitBlock();
+  }
+
+  BitstreamCursor Stream(
+      ArrayRef<uint8_t>((const uint8_t *)Buffer.begin(), Buffer.size()));
+  BitstreamBlockInfo BlockInfo;
+  Stream.setBlockInfo(&BlockInfo);
+
+  BitstreamEntry Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::SubBlock, Entry.Kind);
+  ASSERT_EQ(unsigned(bitc::BLOCKINFO_BLOCK_ID), Entry.ID);
+  Optional<BitstreamBlockInfo> NewBlockInfo = Stream.ReadBlockInfoBlock();
+  ASSERT_TRUE(NewBlockInfo.hasValue());
+  BlockInfo = std::move(*NewBlockInfo);
+
+  SmallVector<uint64_t, 1> Record;
+  auto expectRecord = [&](unsigned AbbrevID, unsigned Code, uint64_t Value) {
+    BitstreamEntry Entry = Stream.advance();
+    ASSERT_EQ(BitstreamEntry::Record, Entry.Kind);
+    ASSERT_EQ(AbbrevID, Entry.ID);
+    Record.clear();
+    EXPECT_EQ(Code, Stream.readRecord(Entry.ID, Record));
+    ASSERT_EQ(1u, Record.size());
+    EXPECT_EQ(Value, Record[0]);
+  };
+
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::SubBlock, Entry.Kind);
+  ASSERT_FALSE(Stream.EnterSubBlock(BlockID));
+  const BitCodeAbbrev *Shared = Stream.getAbbrev(SharedID);
+
+  Entry = Stream.advance();
+  ASSERT_EQ(BitstreamEntry::SubBlock, Entry.Kind);
+  ASSERT_FALSE(Stream.EnterSubBlock(BlockID));
+  EXPECT_EQ(Shared, Stream.getAbbrev(SharedID));
+  expectRecord(SharedID, 1, 10);
+  expectRecord(LocalID, 3, 1000);
+  ASSERT_EQ(BitstreamEntry::EndBlock, Stream.advance().Kind);
+
+  // Leaving the nested block restores the outer block's own abbreviation.
+  EXPECT_EQ(Shared, Stream.getAbbrev(SharedID));
+  expectRecord(SharedID, 1, 20);
+  expectRecord(LocalID, 2, 5);
+  ASSERT_EQ(BitstreamEntry::EndBlock, Stream.advance().Kind);
+}
+
 TEST(BitstreamReaderTest, shortRead) {
   uint8_t Bytes[] = {8, 7, 6, 5, 4, 3, 2, 1};
   for (unsigned I = 1; I != 8; ++I) {
@@ -0,0 +1,137 @@
+//===- llvm/unittest/IR/ValueArenaTest.cpp - ValueArena unit tests --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IR/ValueArena.h"
+#include "llvm/AsmParser/Parser.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/SourceMgr.h"
+#include "gtest/gtest.h"
+using namespace llvm;
+
+namespace {
+
+static std::unique_ptr<Module> parseIR(LLVMContext &C, const char *IR) {
+  SMDiagnostic Err;
+  std::unique_ptr<Module> M = parseAssemblyString(IR, Err, C);
+  if (!M)
+    Err.print("ValueArenaTest", errs());
+  return M;
+}
+
+const char *LoopIR = "define i32 @f(i32 %a, i32 %b, i1 %c) {\n"
+                     "entry:\n"
+                     "  br label %loop\n"
+                     "loop:\n"
+                     "  %x = phi i32 [ %a, %entry ], [ %y, %loop ]\n"
+                     "  %y = add i32 %x, %b\n"
+                     "  br i1 %c, label %loop, label %exit\n"
+                     "exit:\n"
+                     "  ret i32 %y\n"
+                     "}\n";
+
+TEST(ValueArenaTest, RecyclesBlocks) {
+  ValueArena Arena;
+  void *P = Arena.allocate(40);
+  EXPECT_EQ(&Arena, ValueArena::getOwner(P));
+  EXPECT_NE(0u, Arena.getBytesInUse());
+
+  ValueArena::deallocate(P);
+  EXPECT_EQ(0u, Arena.getBytesInUse());
+
+  // A request of the same size class reuses the freed block.
+  EXPECT_EQ(P, Arena.allocate(36));
+  EXPECT_EQ(1u, Arena.getNumRecycled());
+}
+
+TEST(ValueArenaTest, OversizedBlocks) {
+  ValueArena Arena;
+  void *Small = Arena.allocate(40);
+  size_t TotalMemory = Arena.getTotalMemory();
+
+  // Blocks that don't fit a size class come from the heap and go back to it,
+  // so freeing and reallocating them doesn't grow the arena.
+  for (unsigned I = 0; I != 16; ++I) {
+    void *Big = Arena.allocate(4096);
+    EXPECT_EQ(&Arena, ValueArena::getOwner(Big));
+    EXPECT_GT(Arena.getBytesInUse(), 4096u);
+    ValueArena::deallocate(Big);
+  }
+  EXPECT_EQ(TotalMemory, Arena.getTotalMemory());
+  EXPECT_EQ(0u, Arena.getNumRecycled());
+
+  ValueArena::deallocate(Small);
+  EXPECT_EQ(0u, Arena.getBytesInUse());
+}
+
+TEST(ValueArenaTest, ScopeRequiresOptIn) {
+  LLVMContext C;
+  {
+    ValueArenaScope Scope(C);
+    EXPECT_EQ(nullptr, ValueArena::getCurrent());
+  }
+
+  C.setArenaAllocateFunctionBodies(true);
+  {
+    ValueArenaScope Scope(C);
+    ValueArena *Arena = ValueArena::getCurrent();
+    EXPECT_NE(nullptr, Arena);
+    {
+      // A nested scope for a context that did not opt in uses the heap.
+      LLVMContext Other;
+      ValueArenaScope InnerScope(Other);
+      EXPECT_EQ(nullptr, ValueArena::getCurrent());
+    }
+    EXPECT_EQ(Arena, ValueArena::getCurrent());
+  }
+  EXPECT_EQ(nullptr, ValueArena::getCurrent());
+}
+
+TEST(ValueArenaTest, FunctionBodies) {
+  LLVMContext C;
+  C.setArenaAllocateFunctionBodies(true);
+
+  ValueArena *Arena;
+  std::unique_ptr<Module> M;
+  {
+    ValueArenaScope Scope(C);
+    Arena = ValueArena::getCurrent();
+    M = parseIR(C, LoopIR);
+  }
+  ASSERT_TRUE(M);
+  size_t BytesInUse = Arena->getBytesInUse();
+  EXPECT_NE(0u, BytesInUse);
+
+  // Growing the hung-off operands of an arena-allocated PHI outside of the
+  // scope keeps them in the arena.
+  Function *F = M->getFunction("f");
+  BasicBlock &Loop = *std::next(F->begin());
+  PHINode *PN = cast<PHINode>(&Loop.front());
+  for (unsigned I = 0; I != 8; ++I)
+    PN->addIncoming(&*F->arg_begin(), &F->getEntryBlock());
+  EXPECT_GT(Arena->getBytesInUse(), BytesInUse);
+  EXPECT_EQ(10u, PN->getNumIncomingValues());
+
+  M.reset();
+  EXPECT_EQ(0u, Arena->getBytesInUse());
+
+  // Parsing the function again reuses the storage of the old one.
+  size_t TotalMemory = Arena->getTotalMemory();
+  {
+    ValueArenaScope Scope(C);
+    M = parseIR(C, LoopIR);
+  }
+  ASSERT_TRUE(M);
+  EXPECT_NE(0u, Arena->getNumRecycled());
+  EXPECT_EQ(TotalMemory, Arena->getTotalMemory());
+}
+
+} // end anonymous namespace
@@ -12,6 +12,7 @@
 #include "llvm/Support/Endian.h"
 #include "gtest/gtest.h"
 #include <string>
+#include <vector>
 
 using namespace llvm;
 
@@ -104,4 +105,37 @@ TEST(StringTableBuilderTest, ELFInOrder) {
   EXPECT_EQ(9U, B.getOffset("foobar"));
 }
 
+TEST(StringTableBuilderTest, LargeELF) {
+  // Enough strings for finalize to sort them on several threads.
+  const unsigned NumStrings = 100000;
+  std::vector<std::string> Names, Suffixes;
+  size_t ExpectedSize = 1;
+  for (unsigned I = 0; I != NumStrings; ++I) {
+    Names.push_back("f" + std::to_string(I) + "_name");
+    Suffixes.push_back(Names.back().substr(1));
+    ExpectedSize += Names.back().size() + 1;
+  }
+
+  StringTableBuilder B(StringTableBuilder::ELF);
+  for (unsigned I = 0; I != NumStrings; ++I) {
+    B.add(Suffixes[I]);
+    B.add(Names[I]);
+  }
+  B.finalize();
+
+  // Every suffix is stored as part of a name.
+  EXPECT_EQ(ExpectedSize, B.getSize());
+
+  SmallString<0> Data;
+  raw_svector_ostream OS(Data);
+  B.write(OS);
+  for (const std::vector<std::string> &Strings : {Names, Suffixes})
+    for (const std::string &S : Strings) {
+      size_t Offset = B.getOffset(S);
+      ASSERT_LT(Offset + S.size(), Data.size());
+      EXPECT_EQ(S, Data.substr(Offset, S.size()));
+      EXPECT_EQ('\0', Data[Offset + S.size()]);
+    }
+}
+
 }
@@ -0,0 +1,63 @@
+#!/usr/bin/env python
+"""A register allocation stress test generator.
+
+This is a python program that creates a large LLVM IR function for llc. A
+number of values are loaded up front and stay live across a long chain of
+diamonds, each of which calls a function on one side. Every value is used
+only once in a while, so the live ranges cross thousands of blocks without
+a use and must be split around the calls.  Compile times in the register
+allocator and the live range splitting code grow with the number of blocks
+each live range crosses.
+
+Example:
+  create_regalloc_stress.py 20000 --values 60 > stress.ll
+  llc -O2 stress.ll -o /dev/null -time-passes
+"""
+
+from __future__ import print_function
+
+import argparse
+import random
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('diamonds', type=int,
+                      help="Number of diamonds in the chain")
+  parser.add_argument('--values', type=int, default=60,
+                      help="Number of values live across the chain")
+  args = parser.parse_args()
+
+  rng = random.Random(2)
+  print("declare void @f(i64)")
+  print("define i64 @stress(i64* %p, i1 %c) {")
+  print("entry:")
+  live = []
+  for v in range(args.values):
+    print("  %%a%d = load volatile i64, i64* %%p" % v)
+    live.append("%%a%d" % v)
+  print("  br label %b0")
+  for b in range(args.diamonds):
+    print("b%d:" % b)
+    print("  br i1 %%c, label %%t%d, label %%e%d" % (b, b))
+    print("t%d:" % b)
+    print("  call void @f(i64 %s)" % live[rng.randrange(args.values)])
+    print("  br label %%j%d" % b)
+    print("e%d:" % b)
+    v = rng.randrange(args.values)
+    print("  %%n%d = add i64 %s, %d" % (b, live[v], b))
+    print("  br label %%j%d" % b)
+    print("j%d:" % b)
+    print("  %%m%d = phi i64 [%s, %%t%d], [%%n%d, %%e%d]" % (b, live[v], b, b, b))
+    live[v] = "%%m%d" % b
+    print("  br label %%b%d" % (b + 1))
+  print("b%d:" % args.diamonds)
+  total = live[0]
+  for v in range(1, args.values):
+    print("  %%s%d = add i64 %s, %s" % (v, total, live[v]))
+    total = "%%s%d" % v
+  print("  ret i64 %s" % total)
+  print("}")
+
+if __name__ == '__main__':
+  main()
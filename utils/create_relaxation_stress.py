@@ -0,0 +1,69 @@
+#!/usr/bin/env python
+"""An assembler relaxation stress test generator.
+
+This is a python program that creates x86-64 assembly with a large number of
+relaxable branches, to be assembled with llvm-mc -filetype=obj.
+
+In the 'chain' shape each branch jumps over the next one to a target that is
+exactly at the edge of the 8-bit displacement range, and the last branch is
+out of range.  Relaxing a branch pushes the previous one out of range, so
+relaxation needs as many passes as there are branches; an assembler that
+rechecks every branch in every pass is quadratic on it.
+
+In the 'random' shape branches jump short random distances forward and
+backward, which resembles compiled code.
+
+Example:
+  create_relaxation_stress.py 1000000 > stress.s
+  llvm-mc -triple=x86_64-- -filetype=obj stress.s -o stress.o -stats
+"""
+
+from __future__ import print_function
+
+import argparse
+import random
+
+def chain(branches, sections):
+  for s in range(sections):
+    print(".section .text.%d,\"ax\",@progbits" % s)
+    far = "far%d" % s
+    for i in range(branches):
+      target = "t%d_%d" % (s, i) if i != branches - 1 else far
+      print("  jmp %s" % target)
+      print("  .skip 40")
+      if i != 0:
+        print("t%d_%d:" % (s, i - 1))
+      print("  .skip 45")
+    print("t%d_%d:" % (s, branches - 1))
+    print("  .skip 200")
+    print("%s:" % far)
+    print("  ret")
+
+def shuffled(branches, sections):
+  rng = random.Random(0)
+  for s in range(sections):
+    print(".section .text.%d,\"ax\",@progbits" % s)
+    for i in range(branches):
+      print("l%d_%d:" % (s, i))
+      print("  incl %eax" if i % 3 == 0 else "  movl $%d, %%eax" % i)
+      target = min(max(i + rng.randint(-40, 40), 0), branches - 1)
+      print("  jne l%d_%d" % (s, target))
+    print("  ret")
+
+def main():
+  parser = argparse.ArgumentParser(
+      description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+  parser.add_argument('branches', type=int,
+                      help="Number of relaxable branches in each section")
+  parser.add_argument('--sections', type=int, default=1,
+                      help="Number of sections to emit")
+  parser.add_argument('--shape', choices=['chain', 'random'], default='chain',
+                      help="How branch targets are laid out")
+  args = parser.parse_args()
+  if args.shape == 'chain':
+    chain(args.branches, args.sections)
+  else:
+    shuffled(args.branches, args.sections)
+
+if __name__ == '__main__':
+  main()